@@ -10,16 +10,54 @@
 
 #pragma once
 
+#include <string.h>
+#include <zephyr/sys/slist.h>
+
 struct k_work_q *zmk_display_work_q(void);
 
 bool zmk_display_is_initialized(void);
 int zmk_display_init(void);
 
+/**
+ * @brief Request that LVGL redraws the display.
+ *
+ * The display is only redrawn when a widget requests it or an LVGL timer or animation is due, so
+ * anything that changes LVGL objects must call this afterwards. Widgets using
+ * ZMK_DISPLAY_WIDGET_LISTENER do this automatically. Must be called from the display work queue.
+ */
+void zmk_display_request_refresh(void);
+
+/**
+ * @brief Get the number of refresh requests which were merged into an already scheduled frame
+ * because of the frame rate limit.
+ */
+uint32_t zmk_display_get_frames_skipped(void);
+
+/**
+ * @brief A widget update which is applied at most once per display frame.
+ */
+struct zmk_display_widget_update {
+    sys_snode_t node;
+    /** Redraws the widget from its latest state. Returns false if nothing changed. */
+    bool (*update)(void);
+    const char *name;
+    bool pending;
+    /** Number of times the widget was redrawn. */
+    uint32_t redraws;
+};
+
+/**
+ * @brief Queue a widget update to be applied before the next display frame is drawn. Queueing an
+ * update which is already pending has no effect, so bursts of events cause a single redraw.
+ */
+void zmk_display_schedule_widget_update(struct zmk_display_widget_update *update);
+
 /**
  * @brief Macro to define a ZMK event listener that handles the thread safety of fetching
- * the necessary state from the system work queue context, invoking a work callback
+ * the necessary state from the system work queue context, invoking a callback
  * in the display queue context, and properly accessing that state safely when performing
- * display/LVGL updates.
+ * display/LVGL updates. The callback runs at most once per display frame, and is skipped if the
+ * state is unchanged since it last ran.
  *
  * @param listener THe ZMK Event manager listener name.
  * @param state_type The struct/enum type used to store/transfer state.
@@ -33,14 +71,29 @@ int zmk_display_init(void);
 #define ZMK_DISPLAY_WIDGET_LISTENER(listener, state_type, cb, state_func)                          \
     K_MUTEX_DEFINE(listener##_mutex);                                                              \
     static state_type __##listener##_state;                                                        \
+    static state_type __##listener##_drawn_state;                                                  \
+    static bool __##listener##_drawn;                                                              \
     static state_type listener##_get_local_state() {                                               \
         k_mutex_lock(&listener##_mutex, K_FOREVER);                                                \
         state_type copy = __##listener##_state;                                                    \
         k_mutex_unlock(&listener##_mutex);                                                         \
         return copy;                                                                               \
     };                                                                                             \
-    static void listener##_work_cb(struct k_work *work) { cb(listener##_get_local_state()); };     \
-    K_WORK_DEFINE(listener##_work, listener##_work_cb);                                            \
+    static bool listener##_update_cb(void) {                                                       \
+        state_type state = listener##_get_local_state();                                           \
+        if (__##listener##_drawn &&                                                                \
+            memcmp(&state, &__##listener##_drawn_state, sizeof(state)) == 0) {                     \
+            return false;                                                                          \
+        }                                                                                          \
+        __##listener##_drawn_state = state;                                                        \
+        __##listener##_drawn = true;                                                               \
+        cb(state);                                                                                 \
+        return true;                                                                               \
+    };                                                                                             \
+    static struct zmk_display_widget_update listener##_update = {                                  \
+        .update = listener##_update_cb,                                                            \
+        .name = #listener,                                                                         \
+    };                                                                                             \
     static void listener##_refresh_state(const zmk_event_t *eh) {                                  \
         k_mutex_lock(&listener##_mutex, K_FOREVER);                                                \
         __##listener##_state = state_func(eh);                                                     \
@@ -48,12 +101,13 @@ int zmk_display_init(void);
     };                                                                                             \
     static void listener##_init() {                                                                \
         listener##_refresh_state(NULL);                                                            \
-        listener##_work_cb(NULL);                                                                  \
+        __##listener##_drawn = false;                                                              \
+        listener##_update_cb();                                                                    \
     }                                                                                              \
     static int listener##_cb(const zmk_event_t *eh) {                                              \
         if (zmk_display_is_initialized()) {                                                        \
             listener##_refresh_state(eh);                                                          \
-            k_work_submit_to_queue(zmk_display_work_q(), &listener##_work);                        \
+            zmk_display_schedule_widget_update(&listener##_update);                                \
         }                                                                                          \
         return ZMK_EV_EVENT_BUBBLE;                                                                \
     }                                                                                              \
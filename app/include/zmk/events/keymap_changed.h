@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zmk/event_manager.h>
+#include <zmk/keymap.h>
+
+struct zmk_keymap_changed {
+    // The keymap revision after the change.
+    uint32_t revision;
+    // The layer whose bindings or name changed, or ZMK_KEYMAP_LAYER_ID_INVAL if more than one
+    // layer or the layer order changed.
+    zmk_keymap_layer_id_t layer_id;
+};
+
+ZMK_EVENT_DECLARE(zmk_keymap_changed);
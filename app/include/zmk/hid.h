@@ -43,6 +43,11 @@
 
 #define ZMK_HID_MOUSE_NUM_BUTTONS 0x05
 
+// Logical range of the 16 bit movement and wheel fields, as declared by the
+// HID_LOGICAL_MIN16(0xFF, -0x7F) and HID_LOGICAL_MAX16(0xFF, 0x7F) items of the mouse descriptor.
+#define ZMK_HID_MOUSE_LOGICAL_MIN16 (-0x7E01)
+#define ZMK_HID_MOUSE_LOGICAL_MAX16 0x7FFF
+
 // See https://www.usb.org/sites/default/files/hid1_11.pdf section 6.2.2.4 Main Items
 
 #define ZMK_HID_MAIN_VAL_DATA (0x00 << 0)
@@ -377,9 +382,9 @@ int zmk_hid_mouse_button_release(zmk_mouse_button_t button);
 int zmk_hid_mouse_buttons_press(zmk_mouse_button_flags_t buttons);
 int zmk_hid_mouse_buttons_release(zmk_mouse_button_flags_t buttons);
 void zmk_hid_mouse_movement_set(int16_t x, int16_t y);
-void zmk_hid_mouse_scroll_set(int8_t x, int8_t y);
+void zmk_hid_mouse_scroll_set(int16_t x, int16_t y);
 void zmk_hid_mouse_movement_update(int16_t x, int16_t y);
-void zmk_hid_mouse_scroll_update(int8_t x, int8_t y);
+void zmk_hid_mouse_scroll_update(int16_t x, int16_t y);
 void zmk_hid_mouse_clear(void);
 
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING)
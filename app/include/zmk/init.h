@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/iterable_sections.h>
+
+/**
+ * Record how long a boot step took, in hardware cycles. Only available with
+ * CONFIG_ZMK_BOOT_PROFILING.
+ */
+void zmk_boot_profile_record(const char *name, uint32_t cycles);
+
+/**
+ * Log every recorded boot step and the total time since the kernel started.
+ */
+void zmk_boot_profile_report(void);
+
+/**
+ * Run the initialization functions registered with ZMK_DEFERRED_SYS_INIT.
+ */
+int zmk_init_run_deferred(void);
+
+#if IS_ENABLED(CONFIG_ZMK_BOOT_PROFILING)
+
+#define ZMK_BOOT_PROFILE_WRAPPER(init_fn) _CONCAT(init_fn, _profiled)
+
+#define ZMK_BOOT_PROFILE_DEFINE(init_fn)                                                           \
+    static int ZMK_BOOT_PROFILE_WRAPPER(init_fn)(void) {                                           \
+        uint32_t start = k_cycle_get_32();                                                         \
+        int ret = init_fn();                                                                       \
+        zmk_boot_profile_record(STRINGIFY(init_fn), k_cycle_get_32() - start);                     \
+        return ret;                                                                                \
+    }
+
+/**
+ * Same as SYS_INIT, but records how long the function takes with CONFIG_ZMK_BOOT_PROFILING.
+ */
+#define ZMK_SYS_INIT(init_fn, level, prio)                                                         \
+    ZMK_BOOT_PROFILE_DEFINE(init_fn)                                                               \
+    SYS_INIT(ZMK_BOOT_PROFILE_WRAPPER(init_fn), level, prio)
+
+/**
+ * Run a statement, recording how long it takes under the given name.
+ */
+#define ZMK_BOOT_PROFILE_STEP(name, statement)                                                     \
+    do {                                                                                           \
+        uint32_t _start = k_cycle_get_32();                                                        \
+        statement;                                                                                 \
+        zmk_boot_profile_record(name, k_cycle_get_32() - _start);                                  \
+    } while (0)
+
+#else
+
+#define ZMK_BOOT_PROFILE_WRAPPER(init_fn) init_fn
+#define ZMK_BOOT_PROFILE_DEFINE(init_fn)
+#define ZMK_SYS_INIT(init_fn, level, prio) SYS_INIT(init_fn, level, prio)
+#define ZMK_BOOT_PROFILE_STEP(name, statement)                                                     \
+    do {                                                                                           \
+        statement;                                                                                 \
+    } while (0)
+
+#endif
+
+struct zmk_deferred_init {
+    int (*init)(void);
+    const char *name;
+};
+
+#if IS_ENABLED(CONFIG_ZMK_DEFERRED_INIT)
+
+/**
+ * For initialization that isn't needed to scan and send the first key press. With
+ * CONFIG_ZMK_DEFERRED_INIT, the function runs from the main thread after every SYS_INIT has
+ * finished and key scanning has started, instead of at the given level and priority.
+ */
+#define ZMK_DEFERRED_SYS_INIT(init_fn, level, prio)                                                \
+    ZMK_BOOT_PROFILE_DEFINE(init_fn)                                                               \
+    STRUCT_SECTION_ITERABLE(zmk_deferred_init, _CONCAT(zmk_deferred_init_, init_fn)) = {           \
+        .init = ZMK_BOOT_PROFILE_WRAPPER(init_fn),                                                 \
+        .name = STRINGIFY(init_fn),                                                                \
+    }
+
+#else
+
+#define ZMK_DEFERRED_SYS_INIT(init_fn, level, prio) ZMK_SYS_INIT(init_fn, level, prio)
+
+#endif
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <zmk/behavior.h>
 #include <zmk/events/position_state_changed.h>
 
 #define ZMK_LAYER_CHILD_LEN_PLUS_ONE(node) 1 +
@@ -49,6 +50,34 @@ const struct zmk_behavior_binding *zmk_keymap_get_layer_binding_at_idx(zmk_keyma
 int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer, uint8_t binding_idx,
                                         const struct zmk_behavior_binding binding);
 
+/**
+ * @brief A single binding change, as passed to zmk_keymap_set_layer_bindings().
+ */
+struct zmk_keymap_binding_edit {
+    zmk_keymap_layer_id_t layer_id;
+    uint8_t binding_idx;
+    struct zmk_behavior_binding binding;
+};
+
+/**
+ * @brief Set several layer bindings at once.
+ *
+ * The location of every edit is checked before any of them are applied, so either all of the
+ * edits are applied or none of them are. The keymap revision is bumped once for the whole batch.
+ * Behaviors and parameters are not validated here, callers should do so first with
+ * zmk_behavior_validate_binding().
+ *
+ * @param edits The binding changes to apply.
+ * @param count The number of entries in @p edits.
+ * @param failed_idx If not NULL, set to the index of the rejected edit on -EINVAL.
+ *
+ * @retval 0 if the edits were applied.
+ * @retval -EINVAL if an edit has an invalid layer or binding index.
+ * @retval -ENOTSUP if the keymap can't be changed at runtime.
+ */
+int zmk_keymap_set_layer_bindings(const struct zmk_keymap_binding_edit *edits, size_t count,
+                                  size_t *failed_idx);
+
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
 int zmk_keymap_add_layer(void);
@@ -69,6 +98,26 @@ int zmk_keymap_set_layer_name(zmk_keymap_layer_id_t id, const char *name, size_t
  */
 int zmk_keymap_check_unsaved_changes(void);
 
+/**
+ * @brief Get the current keymap revision.
+ *
+ * The revision starts at zero and increases by one on every change to a binding, a layer name or
+ * the layer order. A zmk_keymap_changed event is raised with the new revision for each change.
+ */
+uint32_t zmk_keymap_get_revision(void);
+
+/**
+ * @brief Get the keymap revision of the last change to a layer's bindings or name.
+ *
+ * A layer has changed since a previously seen revision if this is greater than that revision.
+ */
+uint32_t zmk_keymap_layer_revision(zmk_keymap_layer_id_t layer);
+
+/**
+ * @brief Get the keymap revision of the last change to the layer order.
+ */
+uint32_t zmk_keymap_layer_order_revision(void);
+
 int zmk_keymap_save_changes(void);
 int zmk_keymap_discard_changes(void);
 int zmk_keymap_reset_settings(void);
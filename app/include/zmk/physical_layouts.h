@@ -59,4 +59,32 @@ int zmk_physical_layouts_get_position_map(uint8_t source, uint8_t dest, size_t m
  * @retval a negative errno value in the case of errors
  * @retval a positive length of the position map array that map is updated to point to.
  */
-int zmk_physical_layouts_get_selected_to_stock_position_map(uint32_t const **map);
\ No newline at end of file
+int zmk_physical_layouts_get_selected_to_stock_position_map(uint32_t const **map);
+
+struct zmk_kscan_event_stats {
+    /** Number of KSCAN events raised as position events. */
+    uint32_t processed;
+    /** Time between the KSCAN driver reporting the last event and it being processed. */
+    uint32_t last_latency_us;
+    /** Largest time between the KSCAN driver reporting an event and it being processed. */
+    uint32_t max_latency_us;
+    /** Sum of the latencies of all processed events. */
+    uint64_t total_latency_us;
+    /** Number of KSCAN events which did not fit in the event queue. */
+    uint32_t overflowed;
+    /** Number of position events synthesized to recover from event queue overflows. */
+    uint32_t recovered;
+};
+
+/**
+ * @brief Get the statistics collected for KSCAN events since boot or the last reset.
+ *
+ * @retval 0 on success.
+ * @retval -ENOTSUP if CONFIG_ZMK_KSCAN_EVENT_STATS is not enabled.
+ */
+int zmk_physical_layouts_get_kscan_event_stats(struct zmk_kscan_event_stats *stats);
+
+/**
+ * @brief Reset the statistics collected for KSCAN events.
+ */
+void zmk_physical_layouts_reset_kscan_event_stats(void);
@@ -10,3 +10,8 @@
 
 typedef uint8_t zmk_mouse_button_flags_t;
 typedef uint16_t zmk_mouse_button_t;
+
+/**
+ * @brief Get the minimum time between pointing reports on the selected transport.
+ */
+int zmk_pointing_report_interval_ms(void);
@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+
 /**
  * Erases all saved settings.
  *
@@ -13,3 +16,49 @@
  * subsystem. This should typically be followed by a call to sys_reboot().
  */
 int zmk_settings_erase(void);
+
+/**
+ * A setting saved through the settings writer.
+ *
+ * `key` and `value` must stay valid for as long as a save may be pending. The value is read
+ * when it is written to flash, not when the save is requested, so it should point at the live
+ * state to save.
+ */
+struct zmk_settings_deferred_save {
+    sys_snode_t node;
+    const char *key;
+    const void *value;
+    size_t len;
+    bool pending;
+};
+
+#define ZMK_SETTINGS_DEFERRED_SAVE_INIT(_key, _value, _len)                                        \
+    {.key = (_key), .value = (_value), .len = (_len)}
+
+/**
+ * Queues a setting to be saved after CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE milliseconds.
+ *
+ * Every pending setting is written together in one batch on the system work queue, once no new
+ * saves have been requested for the debounce time. Requesting a save for a setting that
+ * is already pending only delays the batch.
+ */
+int zmk_settings_save_deferred(struct zmk_settings_deferred_save *save);
+
+struct zmk_settings_writer_stats {
+    // Settings waiting to be written.
+    uint32_t pending;
+    // Settings written since boot.
+    uint32_t writes;
+    // Save requests merged into an already pending save.
+    uint32_t coalesced;
+    // Writes that failed.
+    uint32_t failures;
+    // Time taken by the most recent and the slowest batch of writes.
+    uint32_t last_batch_ms;
+    uint32_t max_batch_ms;
+};
+
+/**
+ * Gets the statistics of the settings writer.
+ */
+void zmk_settings_writer_get_stats(struct zmk_settings_writer_stats *stats);
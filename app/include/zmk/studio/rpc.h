@@ -219,6 +219,12 @@ struct ring_buf *zmk_rpc_get_tx_buf(void);
 struct ring_buf *zmk_rpc_get_rx_buf(void);
 void zmk_rpc_rx_notify(void);
 
+/**
+ * @brief Notify the RPC subsystem that the transport has removed data from the TX buffer. Wakes up
+ * a response encoder which is waiting for room in a full buffer.
+ */
+void zmk_rpc_tx_space_notify(void);
+
 #define ZMK_RPC_TRANSPORT(name, _transport, _rx_start, _rx_stop, _tx_user_data, _tx_notify)        \
     STRUCT_SECTION_ITERABLE(zmk_rpc_transport, name) = {                                           \
         .transport = _transport,                                                                   \
@@ -14,6 +14,10 @@
 #include <zephyr/drivers/spi.h>
 #include <zephyr/sys/byteorder.h>
 
+#if IS_ENABLED(CONFIG_ZMK_DISPLAY)
+#include <zmk/display.h>
+#endif
+
 #include "il0323_regs.h"
 
 #include <zephyr/logging/log.h>
@@ -34,7 +38,7 @@ LOG_MODULE_REGISTER(il0323, CONFIG_DISPLAY_LOG_LEVEL);
 #define IL0323_PANEL_LAST_GATE (EPD_PANEL_HEIGHT - 1)
 #define IL0323_PANEL_FIRST_PAGE 0U
 #define IL0323_PANEL_LAST_PAGE (IL0323_NUMOF_PAGES - 1)
-#define IL0323_BUFFER_SIZE 1280
+#define IL0323_BUFFER_SIZE (IL0323_NUMOF_PAGES * EPD_PANEL_HEIGHT)
 
 struct il0323_cfg {
     struct gpio_dt_spec reset;
@@ -45,7 +49,19 @@ struct il0323_cfg {
 
 static uint8_t il0323_pwr[] = DT_INST_PROP(0, pwr);
 
-static uint8_t last_buffer[IL0323_BUFFER_SIZE];
+/* Byte-aligned window of the panel, in pages (columns of 8 pixels) and rows. */
+struct il0323_window {
+    uint16_t first_page;
+    uint16_t last_page;
+    uint16_t first_row;
+    uint16_t last_row;
+};
+
+/* What the panel currently shows, and what has been written since the last refresh. */
+static uint8_t displayed_buffer[IL0323_BUFFER_SIZE];
+static uint8_t pending_buffer[IL0323_BUFFER_SIZE];
+static K_MUTEX_DEFINE(pending_lock);
+static struct k_work_delayable refresh_work;
 static bool blanking_on = true;
 static bool init_clear_done = false;
 
@@ -95,39 +111,113 @@ static int il0323_update_display(const struct device *dev) {
     return 0;
 }
 
-static int il0323_write(const struct device *dev, const uint16_t x, const uint16_t y,
-                        const struct display_buffer_descriptor *desc, const void *buf) {
-    const struct il0323_cfg *cfg = dev->config;
-    uint16_t x_end_idx = x + desc->width - 1;
-    uint16_t y_end_idx = y + desc->height - 1;
-    uint8_t ptl[IL0323_PTL_REG_LENGTH] = {0};
-    size_t buf_len;
+static size_t il0323_window_len(const struct il0323_window *win) {
+    return (win->last_page - win->first_page + 1) * (win->last_row - win->first_row + 1);
+}
 
-    LOG_DBG("x %u, y %u, height %u, width %u, pitch %u", x, y, desc->height, desc->width,
-            desc->pitch);
+/*
+ * Send a window as the data of `cmd`, one row at a time. Row N of the window is read from
+ * `src + N * stride`, so a stride of 0 repeats a single row.
+ */
+static int il0323_write_window(const struct il0323_cfg *cfg, uint8_t cmd, const uint8_t *src,
+                               size_t stride, const struct il0323_window *win) {
+    const size_t width = win->last_page - win->first_page + 1;
+    const size_t rows = win->last_row - win->first_row + 1;
+    struct spi_buf buf = {.len = width};
+    struct spi_buf_set buf_set = {.buffers = &buf, .count = 1};
 
-    buf_len = MIN(desc->buf_size, desc->height * desc->width / IL0323_PIXELS_PER_BYTE);
-    __ASSERT(desc->width <= desc->pitch, "Pitch is smaller then width");
-    __ASSERT(buf != NULL, "Buffer is not available");
-    __ASSERT(buf_len != 0U, "Buffer of length zero");
-    __ASSERT(!(desc->width % IL0323_PIXELS_PER_BYTE), "Buffer width not multiple of %d",
-             IL0323_PIXELS_PER_BYTE);
+    if (il0323_write_cmd(cfg, cmd, NULL, 0)) {
+        return -EIO;
+    }
 
-    LOG_DBG("buf_len %d", buf_len);
-    if ((y_end_idx > (EPD_PANEL_HEIGHT - 1)) || (x_end_idx > (EPD_PANEL_WIDTH - 1))) {
-        LOG_ERR("Position out of bounds");
-        return -EINVAL;
+    gpio_pin_set_dt(&cfg->dc, 0);
+
+    /* Full width rows of a panel buffer are contiguous, so they go out in one transfer. */
+    if (stride == width) {
+        buf.buf = (uint8_t *)src;
+        buf.len = width * rows;
+        return spi_write_dt(&cfg->spi, &buf_set) ? -EIO : 0;
+    }
+
+    for (size_t row = 0; row < rows; row++) {
+        buf.buf = (uint8_t *)&src[row * stride];
+        if (spi_write_dt(&cfg->spi, &buf_set)) {
+            return -EIO;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Refreshes wait on the panel's busy signal. Run them on the same queue that renders the
+ * display, so they only hold up key processing if rendering already does.
+ */
+static struct k_work_q *il0323_refresh_q(void) {
+#if IS_ENABLED(CONFIG_ZMK_DISPLAY)
+    return zmk_display_work_q();
+#else
+    return &k_sys_work_q;
+#endif
+}
+
+static inline const uint8_t *il0323_window_start(const uint8_t *panel,
+                                                 const struct il0323_window *win) {
+    return &panel[win->first_row * IL0323_NUMOF_PAGES + win->first_page];
+}
+
+static void il0323_copy_window(uint8_t *dst, const uint8_t *src, const struct il0323_window *win) {
+    const size_t width = win->last_page - win->first_page + 1;
+
+    for (uint16_t row = win->first_row; row <= win->last_row; row++) {
+        const size_t offset = row * IL0323_NUMOF_PAGES + win->first_page;
+
+        memcpy(&dst[offset], &src[offset], width);
+    }
+}
+
+/* Find the smallest window containing every byte that differs between the two buffers. */
+static bool il0323_find_dirty_window(struct il0323_window *win) {
+    bool dirty = false;
+
+    for (uint16_t row = 0; row < EPD_PANEL_HEIGHT; row++) {
+        const uint8_t *old = &displayed_buffer[row * IL0323_NUMOF_PAGES];
+        const uint8_t *new = &pending_buffer[row * IL0323_NUMOF_PAGES];
+
+        if (memcmp(old, new, IL0323_NUMOF_PAGES) == 0) {
+            continue;
+        }
+
+        for (uint16_t page = 0; page < IL0323_NUMOF_PAGES; page++) {
+            if (old[page] == new[page]) {
+                continue;
+            }
+
+            if (!dirty) {
+                *win = (struct il0323_window){page, page, row, row};
+                dirty = true;
+            } else {
+                win->first_page = MIN(win->first_page, page);
+                win->last_page = MAX(win->last_page, page);
+                win->last_row = row;
+            }
+        }
     }
 
-    /* Setup Partial Window and enable Partial Mode */
-    ptl[IL0323_PTL_HRST_IDX] = x;
-    ptl[IL0323_PTL_HRED_IDX] = x_end_idx;
-    ptl[IL0323_PTL_VRST_IDX] = y;
-    ptl[IL0323_PTL_VRED_IDX] = y_end_idx;
+    return dirty;
+}
+
+static int il0323_set_partial_window(const struct il0323_cfg *cfg,
+                                     const struct il0323_window *win) {
+    uint8_t ptl[IL0323_PTL_REG_LENGTH] = {0};
+
+    ptl[IL0323_PTL_HRST_IDX] = win->first_page * IL0323_PIXELS_PER_BYTE;
+    ptl[IL0323_PTL_HRED_IDX] = (win->last_page + 1) * IL0323_PIXELS_PER_BYTE - 1;
+    ptl[IL0323_PTL_VRST_IDX] = win->first_row;
+    ptl[IL0323_PTL_VRED_IDX] = win->last_row;
     ptl[sizeof(ptl) - 1] = IL0323_PTL_PT_SCAN;
     LOG_HEXDUMP_DBG(ptl, sizeof(ptl), "ptl");
 
-    il0323_busy_wait(cfg);
     if (il0323_write_cmd(cfg, IL0323_CMD_PIN, NULL, 0)) {
         return -EIO;
     }
@@ -136,21 +226,56 @@ static int il0323_write(const struct device *dev, const uint16_t x, const uint16
         return -EIO;
     }
 
-    if (il0323_write_cmd(cfg, IL0323_CMD_DTM1, last_buffer, IL0323_BUFFER_SIZE)) {
-        return -EIO;
+    return 0;
+}
+
+/**
+ * Send only the window which changed since the last refresh, and refresh it. Several writes
+ * made before the refresh runs are combined into a single transfer and panel update.
+ */
+static int il0323_refresh(const struct device *dev) {
+    const struct il0323_cfg *cfg = dev->config;
+    struct il0323_window win;
+    size_t len = 0;
+    int ret = 0;
+
+    k_mutex_lock(&pending_lock, K_FOREVER);
+
+    if (!il0323_find_dirty_window(&win)) {
+        goto unlock;
     }
 
-    if (il0323_write_cmd(cfg, IL0323_CMD_DTM2, (uint8_t *)buf, buf_len)) {
-        return -EIO;
+    len = il0323_window_len(&win);
+
+    LOG_DBG("Refresh pages %u-%u, rows %u-%u, %zu bytes", win.first_page, win.last_page,
+            win.first_row, win.last_row, len);
+
+    il0323_busy_wait(cfg);
+    if (il0323_set_partial_window(cfg, &win)) {
+        ret = -EIO;
+        goto unlock;
+    }
+
+    if (il0323_write_window(cfg, IL0323_CMD_DTM1, il0323_window_start(displayed_buffer, &win),
+                            IL0323_NUMOF_PAGES, &win) ||
+        il0323_write_window(cfg, IL0323_CMD_DTM2, il0323_window_start(pending_buffer, &win),
+                            IL0323_NUMOF_PAGES, &win)) {
+        ret = -EIO;
+        goto unlock;
     }
 
-    memcpy(last_buffer, (uint8_t *)buf, IL0323_BUFFER_SIZE);
+    il0323_copy_window(displayed_buffer, pending_buffer, &win);
+
+unlock:
+    k_mutex_unlock(&pending_lock);
+
+    if (ret || len == 0) {
+        return ret;
+    }
 
     /* Update partial window and disable Partial Mode */
-    if (blanking_on == false) {
-        if (il0323_update_display(dev)) {
-            return -EIO;
-        }
+    if (il0323_update_display(dev)) {
+        return -EIO;
     }
 
     if (il0323_write_cmd(cfg, IL0323_CMD_POUT, NULL, 0)) {
@@ -160,6 +285,49 @@ static int il0323_write(const struct device *dev, const uint16_t x, const uint16
     return 0;
 }
 
+static int il0323_write(const struct device *dev, const uint16_t x, const uint16_t y,
+                        const struct display_buffer_descriptor *desc, const void *buf) {
+    uint16_t x_end_idx = x + desc->width - 1;
+    uint16_t y_end_idx = y + desc->height - 1;
+    const size_t pitch_len = desc->pitch / IL0323_PIXELS_PER_BYTE;
+    const size_t width_len = desc->width / IL0323_PIXELS_PER_BYTE;
+    const uint8_t *src = buf;
+
+    LOG_DBG("x %u, y %u, height %u, width %u, pitch %u", x, y, desc->height, desc->width,
+            desc->pitch);
+
+    __ASSERT(desc->width <= desc->pitch, "Pitch is smaller then width");
+    __ASSERT(buf != NULL, "Buffer is not available");
+    __ASSERT(desc->buf_size >= (desc->height - 1) * pitch_len + width_len, "Buffer too small");
+    __ASSERT(!(desc->width % IL0323_PIXELS_PER_BYTE), "Buffer width not multiple of %d",
+             IL0323_PIXELS_PER_BYTE);
+
+    if ((y_end_idx > (EPD_PANEL_HEIGHT - 1)) || (x_end_idx > (EPD_PANEL_WIDTH - 1))) {
+        LOG_ERR("Position out of bounds");
+        return -EINVAL;
+    }
+
+    if (x % IL0323_PIXELS_PER_BYTE) {
+        LOG_ERR("X position not multiple of %d", IL0323_PIXELS_PER_BYTE);
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&pending_lock, K_FOREVER);
+
+    for (uint16_t row = 0; row < desc->height; row++) {
+        memcpy(&pending_buffer[(y + row) * IL0323_NUMOF_PAGES + x / IL0323_PIXELS_PER_BYTE],
+               &src[row * pitch_len], width_len);
+    }
+
+    k_mutex_unlock(&pending_lock);
+
+    if (!blanking_on) {
+        k_work_schedule_for_queue(il0323_refresh_q(), &refresh_work, K_MSEC(IL0323_REFRESH_DELAY));
+    }
+
+    return 0;
+}
+
 static int il0323_read(const struct device *dev, const uint16_t x, const uint16_t y,
                        const struct display_buffer_descriptor *desc, void *buf) {
     LOG_ERR("not supported");
@@ -167,26 +335,35 @@ static int il0323_read(const struct device *dev, const uint16_t x, const uint16_
 }
 
 static int il0323_clear_and_write_buffer(const struct device *dev, uint8_t pattern, bool update) {
-    struct display_buffer_descriptor desc = {
-        .buf_size = IL0323_NUMOF_PAGES,
-        .width = EPD_PANEL_WIDTH,
-        .height = 1,
-        .pitch = EPD_PANEL_WIDTH,
+    const struct il0323_cfg *cfg = dev->config;
+    const struct il0323_window win = {
+        .first_page = IL0323_PANEL_FIRST_PAGE,
+        .last_page = IL0323_PANEL_LAST_PAGE,
+        .first_row = IL0323_PANEL_FIRST_GATE,
+        .last_row = IL0323_PANEL_LAST_GATE,
     };
-    uint8_t *line;
+    uint8_t row[IL0323_NUMOF_PAGES];
+
+    memset(row, pattern, sizeof(row));
 
-    line = k_malloc(IL0323_NUMOF_PAGES);
-    if (line == NULL) {
-        LOG_ERR("Failed to allocate memory for the clear");
-        return -ENOMEM;
+    k_mutex_lock(&pending_lock, K_FOREVER);
+
+    int ret = il0323_set_partial_window(cfg, &win);
+    if (!ret && (il0323_write_window(cfg, IL0323_CMD_DTM1, row, 0, &win) ||
+                 il0323_write_window(cfg, IL0323_CMD_DTM2, row, 0, &win) ||
+                 il0323_write_cmd(cfg, IL0323_CMD_POUT, NULL, 0))) {
+        ret = -EIO;
     }
 
-    memset(line, pattern, IL0323_NUMOF_PAGES);
-    for (int i = 0; i < EPD_PANEL_HEIGHT; i++) {
-        il0323_write(dev, 0, i, &desc, line);
+    if (!ret) {
+        memset(displayed_buffer, pattern, IL0323_BUFFER_SIZE);
     }
 
-    k_free(line);
+    k_mutex_unlock(&pending_lock);
+
+    if (ret) {
+        return ret;
+    }
 
     if (update == true) {
         if (il0323_update_display(dev)) {
@@ -197,23 +374,33 @@ static int il0323_clear_and_write_buffer(const struct device *dev, uint8_t patte
     return 0;
 }
 
-static int il0323_blanking_off(const struct device *dev) {
+static void il0323_refresh_work_handler(struct k_work *work) {
+    const struct device *dev = DEVICE_DT_INST_GET(0);
     const struct il0323_cfg *cfg = dev->config;
 
+    if (blanking_on) {
+        return;
+    }
+
     if (!init_clear_done) {
         /* Update EPD panel in normal mode */
         il0323_busy_wait(cfg);
         if (il0323_clear_and_write_buffer(dev, 0xff, true)) {
-            return -EIO;
+            LOG_ERR("Failed to clear display");
+            return;
         }
         init_clear_done = true;
     }
 
+    if (il0323_refresh(dev)) {
+        LOG_ERR("Failed to refresh display");
+    }
+}
+
+static int il0323_blanking_off(const struct device *dev) {
     blanking_on = false;
 
-    if (il0323_update_display(dev)) {
-        return -EIO;
-    }
+    k_work_reschedule_for_queue(il0323_refresh_q(), &refresh_work, K_NO_WAIT);
 
     return 0;
 }
@@ -368,6 +555,9 @@ static int il0323_init(const struct device *dev) {
 
     gpio_pin_configure_dt(&cfg->busy, GPIO_INPUT);
 
+    memset(pending_buffer, 0xff, IL0323_BUFFER_SIZE);
+    k_work_init_delayable(&refresh_work, il0323_refresh_work_handler);
+
     return il0323_controller_init(dev);
 }
 
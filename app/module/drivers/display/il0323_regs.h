@@ -77,5 +77,6 @@
 #define IL0323_RESET_DELAY 10U
 #define IL0323_PON_DELAY 100U
 #define IL0323_BUSY_DELAY 1U
+#define IL0323_REFRESH_DELAY 10U
 
 #endif /* ZEPHYR_DRIVERS_DISPLAY_IL0323_REGS_H_ */
\ No newline at end of file
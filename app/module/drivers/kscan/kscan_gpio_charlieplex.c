@@ -22,6 +22,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #define INST_LEN(n) DT_INST_PROP_LEN(n, gpios)
 #define INST_CHARLIEPLEX_LEN(n) (INST_LEN(n) * INST_LEN(n))
+#define INST_ACTIVE_ROWS_LEN(n) DIV_ROUND_UP(INST_LEN(n), 32)
 
 #if CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS >= 0
 #define INST_DEBOUNCE_PRESS_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS
@@ -64,6 +65,20 @@ struct kscan_charlieplex_data {
      * (config->cells.length ^2)
      */
     struct zmk_debounce_state *charlieplex_state;
+    /** Bitmap of drive lines which had an active key when they were last scanned. */
+    uint32_t *active_rows;
+    /** Number of scans left before drive lines with no active keys are read again. */
+    uint8_t scans_until_full;
+    /** True if every cell is known to be configured as an input. */
+    bool all_inputs;
+    /** True between the first scan after an interrupt or poll and returning to idle. */
+    bool scanning;
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_CHARLIEPLEX_SCAN_COUNTERS)
+    /** Start time and number of scans (and full scans) of the current burst. */
+    int64_t scan_start;
+    uint32_t scan_count;
+    uint32_t full_scan_count;
+#endif
 };
 
 struct kscan_gpio_list {
@@ -149,6 +164,9 @@ static int kscan_charlieplex_set_all_as_input(const struct device *dev) {
 
 static int kscan_charlieplex_set_all_outputs(const struct device *dev, const int value) {
     const struct kscan_charlieplex_config *config = dev->config;
+    struct kscan_charlieplex_data *data = dev->data;
+
+    data->all_inputs = false;
 
     for (int i = 0; i < config->cells.len; i++) {
         const struct gpio_dt_spec *gpio = &config->cells.gpios[i];
@@ -170,6 +188,9 @@ static int kscan_charlieplex_set_all_outputs(const struct device *dev, const int
 
 static int kscan_charlieplex_disconnect_all(const struct device *dev) {
     const struct kscan_charlieplex_config *config = dev->config;
+    struct kscan_charlieplex_data *data = dev->data;
+
+    data->all_inputs = false;
 
     for (int i = 0; i < config->cells.len; i++) {
         const struct gpio_dt_spec *gpio = &config->cells.gpios[i];
@@ -231,6 +252,13 @@ static void kscan_charlieplex_read_end(const struct device *dev) {
     struct kscan_charlieplex_data *data = dev->data;
     const struct kscan_charlieplex_config *config = dev->config;
 
+    data->scanning = false;
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_CHARLIEPLEX_SCAN_COUNTERS)
+    LOG_DBG("Idle after %u scans (%u full) in %lld ms", data->scan_count, data->full_scan_count,
+            k_uptime_get() - data->scan_start);
+#endif
+
     if (config->use_interrupt) {
         // Return to waiting for an interrupt.
         kscan_charlieplex_interrupt_enable(dev);
@@ -247,16 +275,58 @@ static int kscan_charlieplex_read(const struct device *dev) {
     const struct kscan_charlieplex_config *config = dev->config;
     bool continue_scan = false;
 
+    if (!data->scanning) {
+        data->scanning = true;
+        data->scans_until_full = 0;
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_CHARLIEPLEX_SCAN_COUNTERS)
+        data->scan_start = k_uptime_get();
+        data->scan_count = 0;
+        data->full_scan_count = 0;
+#endif
+    }
+
+    // While keys are active, drive lines with no active keys are only read every
+    // CONFIG_ZMK_KSCAN_CHARLIEPLEX_IDLE_SCAN_INTERVAL scans. Keys on those lines were
+    // idle when last read, so skipping them cannot miss a release. A tap on a skipped
+    // line that is shorter than the skipped scans is never seen, though.
+    const bool full_scan = data->scans_until_full == 0;
+
+    if (full_scan) {
+        data->scans_until_full = CONFIG_ZMK_KSCAN_CHARLIEPLEX_IDLE_SCAN_INTERVAL - 1;
+    } else {
+        data->scans_until_full--;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_CHARLIEPLEX_SCAN_COUNTERS)
+    data->scan_count++;
+    data->full_scan_count += full_scan;
+#endif
+
     // NOTE: RR vs MATRIX: set all pins as input, in case there was a failure on a
-    // previous scan, and one of the pins is still set as output
-    int err = kscan_charlieplex_set_all_as_input(dev);
-    if (err) {
-        return err;
+    // previous scan, and one of the pins is still set as output. Only skip this when
+    // idle drive lines are being skipped too, so the default interval scans as it
+    // always has.
+    int err = 0;
+    if (CONFIG_ZMK_KSCAN_CHARLIEPLEX_IDLE_SCAN_INTERVAL == 1 || !data->all_inputs) {
+        err = kscan_charlieplex_set_all_as_input(dev);
+        if (err) {
+            return err;
+        }
+
+        data->all_inputs = true;
     }
 
     // Scan the matrix.
     for (int row = 0; row < config->cells.len; row++) {
+        if (!full_scan && !(data->active_rows[row / 32] & BIT(row % 32))) {
+            continue;
+        }
+
         const struct gpio_dt_spec *out_gpio = &config->cells.gpios[row];
+        bool row_active = false;
+
+        data->all_inputs = false;
         err = kscan_charlieplex_set_as_output(out_gpio);
         if (err) {
             return err;
@@ -285,13 +355,17 @@ static int kscan_charlieplex_read(const struct device *dev) {
                 LOG_DBG("Sending event at %i,%i state %s", row, col, pressed ? "on" : "off");
                 data->callback(dev, row, col, pressed);
             }
-            continue_scan = continue_scan || zmk_debounce_is_active(state);
+            row_active = row_active || zmk_debounce_is_active(state);
         }
 
         err = kscan_charlieplex_set_as_input(out_gpio);
         if (err) {
             return err;
         }
+
+        data->all_inputs = true;
+        WRITE_BIT(data->active_rows[row / 32], row % 32, row_active);
+        continue_scan = continue_scan || row_active;
 #if CONFIG_ZMK_KSCAN_CHARLIEPLEX_WAIT_BETWEEN_OUTPUTS > 0
         k_busy_wait(CONFIG_ZMK_KSCAN_CHARLIEPLEX_WAIT_BETWEEN_OUTPUTS);
 #endif
@@ -336,6 +410,7 @@ static int kscan_charlieplex_enable(const struct device *dev) {
 static int kscan_charlieplex_disable(const struct device *dev) {
     struct kscan_charlieplex_data *data = dev->data;
     k_work_cancel_delayable(&data->work);
+    data->scanning = false;
 
     const struct kscan_charlieplex_config *config = dev->config;
     if (config->use_interrupt) {
@@ -439,10 +514,12 @@ static const struct kscan_driver_api kscan_charlieplex_api = {
                  "ZMK_KSCAN_DEBOUNCE_RELEASE_MS or debounce-release-ms is too large");             \
                                                                                                    \
     static struct zmk_debounce_state kscan_charlieplex_state_##n[INST_CHARLIEPLEX_LEN(n)];         \
+    static uint32_t kscan_charlieplex_active_rows_##n[INST_ACTIVE_ROWS_LEN(n)];                    \
     static const struct gpio_dt_spec kscan_charlieplex_cells_##n[] = {                             \
         LISTIFY(INST_LEN(n), KSCAN_GPIO_CFG_INIT, (, ), n)};                                       \
     static struct kscan_charlieplex_data kscan_charlieplex_data_##n = {                            \
         .charlieplex_state = kscan_charlieplex_state_##n,                                          \
+        .active_rows = kscan_charlieplex_active_rows_##n,                                          \
     };                                                                                             \
                                                                                                    \
     static const struct kscan_charlieplex_config kscan_charlieplex_config_##n = {                  \
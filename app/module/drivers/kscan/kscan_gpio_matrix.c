@@ -14,8 +14,11 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/__assert.h>
+#include <zephyr/sys/math_extras.h>
 #include <zephyr/sys/util.h>
 
+#include <string.h>
+
 #include <zmk/debounce.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
@@ -28,8 +31,11 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #define INST_ROWS_LEN(n) DT_INST_PROP_LEN(n, row_gpios)
 #define INST_COLS_LEN(n) DT_INST_PROP_LEN(n, col_gpios)
-#define INST_MATRIX_LEN(n) (INST_ROWS_LEN(n) * INST_COLS_LEN(n))
 #define INST_INPUTS_LEN(n) COND_DIODE_DIR(n, (INST_COLS_LEN(n)), (INST_ROWS_LEN(n)))
+#define INST_OUTPUTS_LEN(n) COND_DIODE_DIR(n, (INST_ROWS_LEN(n)), (INST_COLS_LEN(n)))
+#define INST_INPUT_GROUPS(n) DIV_ROUND_UP(INST_INPUTS_LEN(n), ZMK_DEBOUNCE_GROUP_WIDTH)
+#define INST_STATE_LEN(n) (INST_OUTPUTS_LEN(n) * INST_INPUT_GROUPS(n))
+#define INST_DIRTY_LEN(n) DIV_ROUND_UP(INST_OUTPUTS_LEN(n), 32)
 
 #if CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS >= 0
 #define INST_DEBOUNCE_PRESS_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS
@@ -80,50 +86,149 @@ struct kscan_matrix_data {
     int64_t scan_time;
     /**
      * Current state of the matrix as a flattened 2D array of length
-     * (config->rows * config->cols)
+     * (config->outputs.len * config->input_groups). Each entry holds the state
+     * for up to ZMK_DEBOUNCE_GROUP_WIDTH inputs on one output.
+     */
+    struct zmk_debounce_group_state *matrix_state;
+    /** Input samples for the current output. Array of length config->input_groups */
+    uint32_t *samples;
+    /**
+     * Bitmap of outputs with at least one key that changed state in the
+     * current scan. Array of length DIV_ROUND_UP(config->outputs.len, 32)
      */
-    struct zmk_debounce_state *matrix_state;
+    uint32_t *dirty_outputs;
+    /** Number of keys which are pressed or still being debounced. */
+    uint32_t active_keys;
 };
 
 struct kscan_matrix_config {
     struct kscan_gpio_list outputs;
-    struct zmk_debounce_config debounce_config;
+    struct zmk_debounce_group_config debounce_config;
     size_t rows;
     size_t cols;
+    size_t input_groups;
     int32_t debounce_scan_period_ms;
     int32_t poll_period_ms;
     enum kscan_diode_direction diode_direction;
 };
 
 /**
- * Get the index into a matrix state array from a row and column.
+ * Get the index into a matrix state array from an output pin index and an input group.
  */
-static int state_index_rc(const struct kscan_matrix_config *config, const int row, const int col) {
-    __ASSERT(row < config->rows, "Invalid row %i", row);
-    __ASSERT(col < config->cols, "Invalid column %i", col);
+static int state_index(const struct kscan_matrix_config *config, const int output_idx,
+                       const int group) {
+    __ASSERT(output_idx < config->outputs.len, "Invalid output %i", output_idx);
+    __ASSERT(group < config->input_groups, "Invalid input group %i", group);
 
-    return (col * config->rows) + row;
+    return (output_idx * config->input_groups) + group;
 }
 
 /**
- * Get the index into a matrix state array from input/output pin indices.
+ * Report every key whose debounced state changed on one output.
  */
-static int state_index_io(const struct kscan_matrix_config *config, const int input_idx,
-                          const int output_idx) {
-    return (config->diode_direction == KSCAN_ROW2COL)
-               ? state_index_rc(config, output_idx, input_idx)
-               : state_index_rc(config, input_idx, output_idx);
+static void kscan_matrix_report_changes(const struct device *dev, const int output_idx) {
+    const struct kscan_matrix_config *config = dev->config;
+    struct kscan_matrix_data *data = dev->data;
+
+    for (int g = 0; g < config->input_groups; g++) {
+        const struct zmk_debounce_group_state *state =
+            &data->matrix_state[state_index(config, output_idx, g)];
+        uint32_t changed = zmk_debounce_group_get_changed(state);
+        const uint32_t pressed = zmk_debounce_group_get_pressed(state);
+
+        while (changed) {
+            const int bit = u32_count_trailing_zeros(changed);
+            const int input_idx = (g * ZMK_DEBOUNCE_GROUP_WIDTH) + bit;
+            const int row = (config->diode_direction == KSCAN_ROW2COL) ? output_idx : input_idx;
+            const int col = (config->diode_direction == KSCAN_ROW2COL) ? input_idx : output_idx;
+            const bool is_pressed = (pressed & BIT(bit)) != 0;
+
+            changed &= changed - 1;
+
+            LOG_DBG("Sending event at %i,%i state %s", row, col, is_pressed ? "on" : "off");
+            data->callback(dev, row, col, is_pressed);
+        }
+    }
+}
+
+static bool kscan_matrix_port_seen_before(const struct kscan_gpio_list *list, const int index) {
+    for (int i = 0; i < index; i++) {
+        if (list->gpios[i].spec.port == list->gpios[index].spec.port) {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 static int kscan_matrix_set_all_outputs(const struct device *dev, const int value) {
     const struct kscan_matrix_config *config = dev->config;
 
+    // Write each port only once. For outputs on a GPIO expander, every write is
+    // a bus transaction.
     for (int i = 0; i < config->outputs.len; i++) {
         const struct gpio_dt_spec *gpio = &config->outputs.gpios[i].spec;
 
-        int err = gpio_pin_set_dt(gpio, value);
+        if (kscan_matrix_port_seen_before(&config->outputs, i)) {
+            continue;
+        }
+
+        gpio_port_pins_t mask = 0;
+
+        for (int j = i; j < config->outputs.len; j++) {
+            if (config->outputs.gpios[j].spec.port == gpio->port) {
+                mask |= BIT(config->outputs.gpios[j].spec.pin);
+            }
+        }
+
+        int err = gpio_port_set_masked(gpio->port, mask, value ? mask : 0);
         if (err) {
-            LOG_ERR("Failed to set output %i to %i: %i", i, value, err);
+            LOG_ERR("Failed to set outputs on %s to %i: %i", gpio->port->name, value, err);
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Set the previously scanned output inactive and the next output active. Either
+ * may be NULL at the start or end of a scan.
+ *
+ * If both outputs are on the same port, this is a single port write, so outputs
+ * on a GPIO expander such as a 595 shift register take one bus transaction per
+ * output instead of two.
+ */
+static int kscan_matrix_strobe(const struct kscan_gpio *prev, const struct kscan_gpio *next) {
+#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS == 0
+    if (prev && next && prev->spec.port == next->spec.port) {
+        const gpio_port_pins_t mask = BIT(prev->spec.pin) | BIT(next->spec.pin);
+
+        int err = gpio_port_set_masked(next->spec.port, mask, BIT(next->spec.pin));
+        if (err) {
+            LOG_ERR("Failed to switch from output %i to %i: %i", prev->index, next->index, err);
+        }
+
+        return err;
+    }
+#endif
+
+    if (prev) {
+        int err = gpio_pin_set_dt(&prev->spec, 0);
+        if (err) {
+            LOG_ERR("Failed to set output %i inactive: %i", prev->index, err);
+            return err;
+        }
+
+#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS > 0
+        k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS);
+#endif
+    }
+
+    if (next) {
+        int err = gpio_pin_set_dt(&next->spec, 1);
+        if (err) {
+            LOG_ERR("Failed to set output %i active: %i", next->index, err);
             return err;
         }
     }
@@ -222,10 +327,10 @@ static int kscan_matrix_read(const struct device *dev) {
     // Scan the matrix.
     for (int i = 0; i < config->outputs.len; i++) {
         const struct kscan_gpio *out_gpio = &config->outputs.gpios[i];
+        const struct kscan_gpio *prev_gpio = (i > 0) ? &config->outputs.gpios[i - 1] : NULL;
 
-        int err = gpio_pin_set_dt(&out_gpio->spec, 1);
+        int err = kscan_matrix_strobe(prev_gpio, out_gpio);
         if (err) {
-            LOG_ERR("Failed to set output %i active: %i", out_gpio->index, err);
             return err;
         }
 
@@ -234,51 +339,65 @@ static int kscan_matrix_read(const struct device *dev) {
 #endif
         struct kscan_gpio_port_state state = {0};
 
+        memset(data->samples, 0, config->input_groups * sizeof(data->samples[0]));
+
         for (int j = 0; j < data->inputs.len; j++) {
             const struct kscan_gpio *in_gpio = &data->inputs.gpios[j];
 
-            const int index = state_index_io(config, in_gpio->index, out_gpio->index);
             const int active = kscan_gpio_pin_get(in_gpio, &state);
             if (active < 0) {
                 LOG_ERR("Failed to read port %s: %i", in_gpio->spec.port->name, active);
                 return active;
             }
 
-            zmk_debounce_update(&data->matrix_state[index], active, config->debounce_scan_period_ms,
-                                &config->debounce_config);
+            if (active) {
+                data->samples[in_gpio->index / ZMK_DEBOUNCE_GROUP_WIDTH] |=
+                    BIT(in_gpio->index % ZMK_DEBOUNCE_GROUP_WIDTH);
+            }
+        }
+
+        for (int g = 0; g < config->input_groups; g++) {
+            struct zmk_debounce_group_state *group_state =
+                &data->matrix_state[state_index(config, out_gpio->index, g)];
+
+            const uint32_t was_active = zmk_debounce_group_get_active(group_state);
+
+            zmk_debounce_group_update(group_state, data->samples[g], &config->debounce_config);
+
+            const uint32_t is_active = zmk_debounce_group_get_active(group_state);
+
+            if (was_active != is_active) {
+                data->active_keys += POPCOUNT(is_active) - POPCOUNT(was_active);
+            }
+
+            if (zmk_debounce_group_get_changed(group_state)) {
+                data->dirty_outputs[out_gpio->index / 32] |= BIT(out_gpio->index % 32);
+            }
         }
+    }
 
-        err = gpio_pin_set_dt(&out_gpio->spec, 0);
+    if (config->outputs.len > 0) {
+        int err = kscan_matrix_strobe(&config->outputs.gpios[config->outputs.len - 1], NULL);
         if (err) {
-            LOG_ERR("Failed to set output %i inactive: %i", out_gpio->index, err);
             return err;
         }
-
-#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS > 0
-        k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS);
-#endif
     }
 
-    // Process the new state.
-    bool continue_scan = false;
-
-    for (int r = 0; r < config->rows; r++) {
-        for (int c = 0; c < config->cols; c++) {
-            const int index = state_index_rc(config, r, c);
-            struct zmk_debounce_state *state = &data->matrix_state[index];
+    // Process the new state. Only outputs with changed keys need to be visited.
+    for (int w = 0; w < DIV_ROUND_UP(config->outputs.len, 32); w++) {
+        uint32_t dirty = data->dirty_outputs[w];
 
-            if (zmk_debounce_get_changed(state)) {
-                const bool pressed = zmk_debounce_is_pressed(state);
+        data->dirty_outputs[w] = 0;
 
-                LOG_DBG("Sending event at %i,%i state %s", r, c, pressed ? "on" : "off");
-                data->callback(dev, r, c, pressed);
-            }
+        while (dirty) {
+            const int bit = u32_count_trailing_zeros(dirty);
 
-            continue_scan = continue_scan || zmk_debounce_is_active(state);
+            dirty &= dirty - 1;
+            kscan_matrix_report_changes(dev, (w * 32) + bit);
         }
     }
 
-    if (continue_scan) {
+    if (data->active_keys > 0) {
         // At least one key is pressed or the debouncer has not yet decided if
         // it is pressed. Poll quickly until everything is released.
         kscan_matrix_read_continue(dev);
@@ -492,11 +611,18 @@ static const struct kscan_driver_api kscan_matrix_api = {
     .disable_callback = kscan_matrix_disable,
 };
 
+#define INST_DEBOUNCE_PRESS_SCANS(n)                                                               \
+    ZMK_DEBOUNCE_MS_TO_SCANS(INST_DEBOUNCE_PRESS_MS(n), DT_INST_PROP(n, debounce_scan_period_ms))
+#define INST_DEBOUNCE_RELEASE_SCANS(n)                                                             \
+    ZMK_DEBOUNCE_MS_TO_SCANS(INST_DEBOUNCE_RELEASE_MS(n), DT_INST_PROP(n, debounce_scan_period_ms))
+
 #define KSCAN_MATRIX_INIT(n)                                                                       \
     BUILD_ASSERT(INST_DEBOUNCE_PRESS_MS(n) <= DEBOUNCE_COUNTER_MAX,                                \
                  "ZMK_KSCAN_DEBOUNCE_PRESS_MS or debounce-press-ms is too large");                 \
     BUILD_ASSERT(INST_DEBOUNCE_RELEASE_MS(n) <= DEBOUNCE_COUNTER_MAX,                              \
                  "ZMK_KSCAN_DEBOUNCE_RELEASE_MS or debounce-release-ms is too large");             \
+    BUILD_ASSERT(DT_INST_PROP(n, debounce_scan_period_ms) > 0,                                     \
+                 "debounce-scan-period-ms must be greater than zero");                             \
                                                                                                    \
     static struct kscan_gpio kscan_matrix_rows_##n[] = {                                           \
         LISTIFY(INST_ROWS_LEN(n), KSCAN_GPIO_ROW_CFG_INIT, (, ), n)};                              \
@@ -504,7 +630,9 @@ static const struct kscan_driver_api kscan_matrix_api = {
     static struct kscan_gpio kscan_matrix_cols_##n[] = {                                           \
         LISTIFY(INST_COLS_LEN(n), KSCAN_GPIO_COL_CFG_INIT, (, ), n)};                              \
                                                                                                    \
-    static struct zmk_debounce_state kscan_matrix_state_##n[INST_MATRIX_LEN(n)];                   \
+    static struct zmk_debounce_group_state kscan_matrix_state_##n[INST_STATE_LEN(n)];              \
+    static uint32_t kscan_matrix_samples_##n[INST_INPUT_GROUPS(n)];                                \
+    static uint32_t kscan_matrix_dirty_##n[INST_DIRTY_LEN(n)];                                     \
                                                                                                    \
     COND_INTERRUPTS(                                                                               \
         (static struct kscan_matrix_irq_callback kscan_matrix_irqs_##n[INST_INPUTS_LEN(n)];))      \
@@ -513,17 +641,21 @@ static const struct kscan_driver_api kscan_matrix_api = {
         .inputs =                                                                                  \
             KSCAN_GPIO_LIST(COND_DIODE_DIR(n, (kscan_matrix_cols_##n), (kscan_matrix_rows_##n))),  \
         .matrix_state = kscan_matrix_state_##n,                                                    \
+        .samples = kscan_matrix_samples_##n,                                                       \
+        .dirty_outputs = kscan_matrix_dirty_##n,                                                   \
         COND_INTERRUPTS((.irqs = kscan_matrix_irqs_##n, ))};                                       \
                                                                                                    \
     static const struct kscan_matrix_config kscan_matrix_config_##n = {                            \
         .rows = ARRAY_SIZE(kscan_matrix_rows_##n),                                                 \
         .cols = ARRAY_SIZE(kscan_matrix_cols_##n),                                                 \
+        .input_groups = INST_INPUT_GROUPS(n),                                                      \
         .outputs =                                                                                 \
             KSCAN_GPIO_LIST(COND_DIODE_DIR(n, (kscan_matrix_rows_##n), (kscan_matrix_cols_##n))),  \
         .debounce_config =                                                                         \
             {                                                                                      \
-                .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
-                .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
+                .algorithm = DT_INST_ENUM_IDX(n, debounce_algorithm),                              \
+                .press_scans = INST_DEBOUNCE_PRESS_SCANS(n),                                       \
+                .release_scans = INST_DEBOUNCE_RELEASE_SCANS(n),                                   \
             },                                                                                     \
         .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
         .poll_period_ms = DT_INST_PROP(n, poll_period_ms),                                         \
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <zephyr/sys/util.h>
+
+/** Speed scale factors are fixed point, with ZMK_ACCEL_SCALE_ONE being full speed. */
+#define ZMK_ACCEL_SCALE_SHIFT 16
+#define ZMK_ACCEL_SCALE_ONE BIT(ZMK_ACCEL_SCALE_SHIFT)
+
+/** Number of linear segments the acceleration curve is approximated with. */
+#define ZMK_ACCEL_CURVE_STEPS 32
+
+/**
+ * Fill @p curve with (i / ZMK_ACCEL_CURVE_STEPS) ^ @p exponent for each curve point i, as a
+ * fraction of ZMK_ACCEL_SCALE_ONE.
+ */
+static inline void zmk_accel_curve_build(uint32_t curve[ZMK_ACCEL_CURVE_STEPS + 1],
+                                         uint8_t exponent) {
+    for (uint32_t i = 0; i <= ZMK_ACCEL_CURVE_STEPS; i++) {
+        uint32_t val = ZMK_ACCEL_SCALE_ONE;
+        for (uint8_t e = 0; e < exponent; e++) {
+            val = val * i / ZMK_ACCEL_CURVE_STEPS;
+        }
+        curve[i] = val;
+    }
+}
+
+/**
+ * Get the speed scale @p elapsed_ms into an acceleration lasting @p total_ms, by interpolating
+ * between the two curve points around the elapsed fraction of @p total_ms.
+ *
+ * @param curve A curve filled in by zmk_accel_curve_build().
+ * @param elapsed_ms Time since the acceleration started.
+ * @param total_ms Time to reach full speed. Must not be zero.
+ */
+static inline uint32_t zmk_accel_curve_scale(const uint32_t curve[ZMK_ACCEL_CURVE_STEPS + 1],
+                                             uint32_t elapsed_ms, uint16_t total_ms) {
+    if (elapsed_ms >= total_ms) {
+        return curve[ZMK_ACCEL_CURVE_STEPS];
+    }
+
+    const uint32_t pos = elapsed_ms * ZMK_ACCEL_CURVE_STEPS;
+    const uint32_t idx = pos / total_ms;
+    const uint32_t frac = ((pos % total_ms) << ZMK_ACCEL_SCALE_SHIFT) / total_ms;
+
+    // A segment can rise by up to ZMK_ACCEL_SCALE_ONE, so its product with frac only just fits in
+    // 32 bits. Do it in 64 bits so that never depends on the curve's shape.
+    return curve[idx] +
+           (uint32_t)(((uint64_t)(curve[idx + 1] - curve[idx]) * frac) >> ZMK_ACCEL_SCALE_SHIFT);
+}
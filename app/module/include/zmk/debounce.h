@@ -54,3 +54,94 @@ bool zmk_debounce_is_pressed(const struct zmk_debounce_state *state);
  * debounce_update.
  */
 bool zmk_debounce_get_changed(const struct zmk_debounce_state *state);
+
+/** Number of switches debounced together by one zmk_debounce_group_state. */
+#define ZMK_DEBOUNCE_GROUP_WIDTH 32
+
+/**
+ * Debounce state for up to ZMK_DEBOUNCE_GROUP_WIDTH switches, stored bit-sliced
+ * so that every switch in the group can be updated with a handful of word
+ * operations. Bit N of each field belongs to switch N of the group.
+ */
+struct zmk_debounce_group_state {
+    /** Bitmap of switches latched as pressed. */
+    uint32_t pressed;
+    /** Bitmap of switches whose pressed state changed in the last update. */
+    uint32_t changed;
+    /** Bitmap of switches which are pressed or not yet decided. */
+    uint32_t active;
+    /** Vertical counters. counter[b] holds bit b of every switch's counter. */
+    uint32_t counter[DEBOUNCE_COUNTER_BITS];
+    /** Bitmap of the last sample. Used by ZMK_DEBOUNCE_ALGORITHM_DEFER_ROW and _LOCKOUT. */
+    uint32_t last_active;
+    /** Scans since last_active changed. Only used by ZMK_DEBOUNCE_ALGORITHM_DEFER_ROW. */
+    uint16_t stable_scans;
+};
+
+enum zmk_debounce_algorithm {
+    /**
+     * Latch a switch once its input has differed from its state for longer
+     * than it has matched it, up to the press/release threshold.
+     */
+    ZMK_DEBOUNCE_ALGORITHM_INTEGRATOR,
+    /**
+     * Latch presses on the first active sample. Latch releases once the
+     * switch has been inactive for the release threshold without interruption.
+     */
+    ZMK_DEBOUNCE_ALGORITHM_EAGER_DEFER,
+    /**
+     * Latch every switch in the group at once after no input in the group has
+     * changed for the larger of the press and release thresholds.
+     */
+    ZMK_DEBOUNCE_ALGORITHM_DEFER_ROW,
+    /**
+     * Latch a switch on the first sample that differs from its state, then
+     * ignore it until its input has been steady for the press or release
+     * threshold.
+     */
+    ZMK_DEBOUNCE_ALGORITHM_LOCKOUT,
+};
+
+struct zmk_debounce_group_config {
+    enum zmk_debounce_algorithm algorithm;
+    /** Number of scans a switch must be pressed to latch as pressed. */
+    uint16_t press_scans;
+    /** Number of scans a switch must be released to latch as released. */
+    uint16_t release_scans;
+};
+
+/**
+ * Converts a debounce time in milliseconds to a number of scans, rounding up to
+ * the next multiple of the scan period like zmk_debounce_update() does.
+ */
+#define ZMK_DEBOUNCE_MS_TO_SCANS(ms, scan_period_ms) DIV_ROUND_UP(ms, scan_period_ms)
+
+/**
+ * Debounces a group of switches which are all sampled at the same time. The
+ * default ZMK_DEBOUNCE_ALGORITHM_INTEGRATOR implements the same integrator as
+ * zmk_debounce_update(), but counts scans instead of milliseconds.
+ *
+ * @param state The state for the group of switches to debounce.
+ * @param active Bitmap of the switches which are currently pressed.
+ * @param config Debounce settings.
+ */
+void zmk_debounce_group_update(struct zmk_debounce_group_state *state, const uint32_t active,
+                               const struct zmk_debounce_group_config *config);
+
+/**
+ * @returns a bitmap of the switches which are either latched as pressed or
+ * potentially pressed but not yet decided. If this is non-zero, the kscan
+ * driver should continue to poll quickly.
+ */
+uint32_t zmk_debounce_group_get_active(const struct zmk_debounce_group_state *state);
+
+/**
+ * @returns a bitmap of the switches latched as pressed.
+ */
+uint32_t zmk_debounce_group_get_pressed(const struct zmk_debounce_group_state *state);
+
+/**
+ * @returns a bitmap of the switches whose pressed state changed in the last
+ * call to zmk_debounce_group_update().
+ */
+uint32_t zmk_debounce_group_get_changed(const struct zmk_debounce_group_state *state);
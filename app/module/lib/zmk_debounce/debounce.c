@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <zephyr/sys/math_extras.h>
+
 #include <zmk/debounce.h>
 
 static uint32_t get_threshold(const struct zmk_debounce_state *state,
@@ -59,4 +61,201 @@ bool zmk_debounce_is_active(const struct zmk_debounce_state *state) {
 
 bool zmk_debounce_is_pressed(const struct zmk_debounce_state *state) { return state->pressed; }
 
-bool zmk_debounce_get_changed(const struct zmk_debounce_state *state) { return state->changed; }
\ No newline at end of file
+bool zmk_debounce_get_changed(const struct zmk_debounce_state *state) { return state->changed; }
+
+/**
+ * Compares every vertical counter in a group against the same constant.
+ *
+ * @returns a bitmap of the switches whose counter is >= threshold.
+ */
+static uint32_t group_counter_at_least(const struct zmk_debounce_group_state *state,
+                                       const int bits, const uint32_t threshold) {
+    uint32_t greater = 0;
+    uint32_t equal = UINT32_MAX;
+
+    for (int b = bits - 1; b >= 0; b--) {
+        const uint32_t threshold_bit = (threshold & BIT(b)) ? UINT32_MAX : 0;
+
+        greater |= equal & state->counter[b] & ~threshold_bit;
+        equal &= ~(state->counter[b] ^ threshold_bit);
+    }
+
+    return greater | equal;
+}
+
+static uint32_t group_counter_nonzero(const struct zmk_debounce_group_state *state,
+                                      const int bits) {
+    uint32_t nonzero = 0;
+
+    for (int b = 0; b < bits; b++) {
+        nonzero |= state->counter[b];
+    }
+
+    return nonzero;
+}
+
+/**
+ * Increments the counters of the switches in carry and decrements the counters
+ * of the switches in borrow. The two sets must not overlap.
+ */
+static void group_counter_step(struct zmk_debounce_group_state *state, const int bits,
+                               uint32_t carry, uint32_t borrow) {
+    for (int b = 0; b < bits && (carry | borrow); b++) {
+        const uint32_t next_carry = state->counter[b] & carry;
+        const uint32_t next_borrow = ~state->counter[b] & borrow;
+
+        state->counter[b] ^= carry | borrow;
+        carry = next_carry;
+        borrow = next_borrow;
+    }
+}
+
+static void group_counter_clear(struct zmk_debounce_group_state *state, const int bits,
+                                const uint32_t mask) {
+    for (int b = 0; b < bits; b++) {
+        state->counter[b] &= ~mask;
+    }
+}
+
+static int group_counter_bits(const struct zmk_debounce_group_config *config) {
+    const uint32_t max_scans = MAX(config->press_scans, config->release_scans);
+
+    // Counters never exceed the larger threshold, so any higher bit planes are
+    // always zero and can be skipped.
+    return max_scans == 0 ? 1 : 32 - u32_count_leading_zeros(max_scans);
+}
+
+static uint32_t group_update_integrator(struct zmk_debounce_group_state *state,
+                                        const uint32_t active,
+                                        const struct zmk_debounce_group_config *config) {
+    // This is the same integrator as zmk_debounce_update(), evaluated for every
+    // switch in the group at once. Each switch whose input does not match its
+    // state either flips (if its counter reached the threshold) or increments
+    // its counter. Every other switch decrements its counter.
+    const int bits = group_counter_bits(config);
+
+    const uint32_t mismatch = active ^ state->pressed;
+    const uint32_t press_reached = group_counter_at_least(state, bits, config->press_scans);
+    const uint32_t release_reached = group_counter_at_least(state, bits, config->release_scans);
+    const uint32_t reached = (state->pressed & release_reached) | (~state->pressed & press_reached);
+
+    const uint32_t flip = mismatch & reached;
+
+    group_counter_step(state, bits, mismatch & ~reached,
+                       ~mismatch & group_counter_nonzero(state, bits));
+    group_counter_clear(state, bits, flip);
+
+    return flip;
+}
+
+static uint32_t group_update_eager_defer(struct zmk_debounce_group_state *state,
+                                         const uint32_t active,
+                                         const struct zmk_debounce_group_config *config) {
+    // A released switch latches as pressed on the first active sample. A
+    // pressed switch latches as released once it has been inactive for
+    // release_scans consecutive scans. Any active sample restarts that count.
+    const int bits = group_counter_bits(config);
+
+    const uint32_t mismatch = active ^ state->pressed;
+    const uint32_t release_reached = group_counter_at_least(state, bits, config->release_scans);
+
+    const uint32_t press = mismatch & ~state->pressed;
+    const uint32_t release = mismatch & state->pressed & release_reached;
+
+    group_counter_clear(state, bits, ~mismatch);
+    group_counter_step(state, bits, mismatch & state->pressed & ~release_reached, 0);
+    group_counter_clear(state, bits, release);
+
+    return press | release;
+}
+
+static uint32_t group_update_defer_row(struct zmk_debounce_group_state *state,
+                                       const uint32_t active,
+                                       const struct zmk_debounce_group_config *config) {
+    // The whole group latches the sampled state at once after no input in the
+    // group has changed for the longer of the two thresholds.
+    const uint16_t threshold = MAX(config->press_scans, config->release_scans);
+
+    if (active != state->last_active) {
+        state->last_active = active;
+        state->stable_scans = 0;
+    }
+
+    if (state->stable_scans < threshold) {
+        state->stable_scans++;
+        return 0;
+    }
+
+    return active ^ state->pressed;
+}
+
+static uint32_t group_update_lockout(struct zmk_debounce_group_state *state,
+                                     const uint32_t active,
+                                     const struct zmk_debounce_group_config *config) {
+    // A switch which is not locked out latches its new state on the very first
+    // sample that differs. It then ignores its input until it has read the same
+    // value for press_scans (after a press) or release_scans (after a release)
+    // scans in a row, so chatter longer than the lockout can't leak through.
+    const int bits = group_counter_bits(config);
+
+    const uint32_t locked = group_counter_nonzero(state, bits);
+    const uint32_t bounced = locked & (active ^ state->last_active);
+    const uint32_t flip = (active ^ state->pressed) & ~locked;
+    const uint32_t pressed = state->pressed ^ flip;
+    const uint32_t reload = flip | bounced;
+
+    state->last_active = active;
+
+    group_counter_step(state, bits, 0, locked & ~bounced);
+    group_counter_clear(state, bits, reload);
+
+    for (int b = 0; b < bits; b++) {
+        if (config->press_scans & BIT(b)) {
+            state->counter[b] |= reload & pressed;
+        }
+
+        if (config->release_scans & BIT(b)) {
+            state->counter[b] |= reload & ~pressed;
+        }
+    }
+
+    return flip;
+}
+
+void zmk_debounce_group_update(struct zmk_debounce_group_state *state, const uint32_t active,
+                               const struct zmk_debounce_group_config *config) {
+    uint32_t flip;
+
+    switch (config->algorithm) {
+    case ZMK_DEBOUNCE_ALGORITHM_EAGER_DEFER:
+        flip = group_update_eager_defer(state, active, config);
+        break;
+    case ZMK_DEBOUNCE_ALGORITHM_DEFER_ROW:
+        flip = group_update_defer_row(state, active, config);
+        break;
+    case ZMK_DEBOUNCE_ALGORITHM_LOCKOUT:
+        flip = group_update_lockout(state, active, config);
+        break;
+    case ZMK_DEBOUNCE_ALGORITHM_INTEGRATOR:
+    default:
+        flip = group_update_integrator(state, active, config);
+        break;
+    }
+
+    state->pressed ^= flip;
+    state->changed = flip;
+    state->active = state->pressed | state->last_active |
+                    group_counter_nonzero(state, group_counter_bits(config));
+}
+
+uint32_t zmk_debounce_group_get_active(const struct zmk_debounce_group_state *state) {
+    return state->active;
+}
+
+uint32_t zmk_debounce_group_get_pressed(const struct zmk_debounce_group_state *state) {
+    return state->pressed;
+}
+
+uint32_t zmk_debounce_group_get_changed(const struct zmk_debounce_group_state *state) {
+    return state->changed;
+}
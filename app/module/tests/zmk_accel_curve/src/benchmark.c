@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <inttypes.h>
+
+#include <zephyr/timing/timing.h>
+#include <zephyr/ztest.h>
+
+#include <zmk/accel_curve.h>
+
+// Compares the time to compute one mouse key speed per tick with the fixed-point curve against
+// the float math the two-axis behavior used before it.
+
+#define TIME_TO_MAX_MS 300
+#define EXPONENT 2
+#define MAX_SPEED 600
+#define BENCHMARK_ROUNDS 20
+
+// The float speed calculation the two-axis behavior used to run on every tick.
+static float float_powf(float base, float exponent) {
+    float power = 1.0f;
+    for (; exponent >= 1.0f; exponent--) {
+        power = power * base;
+    }
+    return power;
+}
+
+static float float_speed(float max_speed, uint32_t elapsed_ms) {
+    float time_fraction = (float)elapsed_ms / TIME_TO_MAX_MS;
+    return max_speed * float_powf(time_fraction, EXPONENT);
+}
+
+static volatile uint32_t sink;
+
+static uint32_t run_float(uint64_t *cycles) {
+    uint32_t total = 0;
+
+    timing_t start = timing_counter_get();
+
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        for (uint32_t ms = 1; ms < TIME_TO_MAX_MS; ms++) {
+            total += (uint32_t)float_speed(MAX_SPEED, ms);
+        }
+    }
+
+    timing_t end = timing_counter_get();
+
+    *cycles = timing_cycles_get(&start, &end);
+    return total;
+}
+
+static uint32_t run_fixed(const uint32_t *curve, uint64_t *cycles) {
+    uint32_t total = 0;
+
+    timing_t start = timing_counter_get();
+
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        for (uint32_t ms = 1; ms < TIME_TO_MAX_MS; ms++) {
+            total += (MAX_SPEED * zmk_accel_curve_scale(curve, ms, TIME_TO_MAX_MS)) >>
+                     ZMK_ACCEL_SCALE_SHIFT;
+        }
+    }
+
+    timing_t end = timing_counter_get();
+
+    *cycles = timing_cycles_get(&start, &end);
+    return total;
+}
+
+static void *benchmark_setup(void) {
+    timing_init();
+    timing_start();
+    return NULL;
+}
+
+static void benchmark_teardown(void *fixture) { timing_stop(); }
+
+ZTEST_SUITE(accel_curve_benchmark, NULL, benchmark_setup, NULL, NULL, benchmark_teardown);
+
+ZTEST(accel_curve_benchmark, test_tick_speed_time) {
+    uint32_t curve[ZMK_ACCEL_CURVE_STEPS + 1];
+    uint64_t float_cycles, fixed_cycles;
+
+    zmk_accel_curve_build(curve, EXPONENT);
+
+    uint32_t float_total = run_float(&float_cycles);
+    uint32_t fixed_total = run_fixed(curve, &fixed_cycles);
+
+    sink = float_total + fixed_total;
+
+    TC_PRINT("%d ticks: float %" PRIu64 " ns, fixed point %" PRIu64 " ns\n",
+             BENCHMARK_ROUNDS * (TIME_TO_MAX_MS - 1), timing_cycles_to_ns(float_cycles),
+             timing_cycles_to_ns(fixed_cycles));
+
+    // Both truncate every tick's speed, but round differently, so allow one unit per tick. The
+    // times are only reported: how much faster fixed point is depends on the core and its FPU.
+    zassert_within(fixed_total, float_total, BENCHMARK_ROUNDS * (TIME_TO_MAX_MS - 1),
+                   "Fixed point sum %u too far from float sum %u", fixed_total, float_total);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdlib.h>
+
+#include <zephyr/ztest.h>
+
+#include <zmk/accel_curve.h>
+
+#define TIME_TO_MAX_MS 300
+
+// (elapsed / total) ^ exponent as a fraction of ZMK_ACCEL_SCALE_ONE, in exact integer math.
+static uint32_t reference_scale(uint32_t elapsed_ms, uint32_t total_ms, uint8_t exponent) {
+    uint64_t num = ZMK_ACCEL_SCALE_ONE;
+    uint64_t den = 1;
+
+    for (uint8_t e = 0; e < exponent; e++) {
+        num *= elapsed_ms;
+        den *= total_ms;
+    }
+
+    return (uint32_t)(num / den);
+}
+
+static void assert_close_to_reference(uint8_t exponent, uint32_t tolerance) {
+    uint32_t curve[ZMK_ACCEL_CURVE_STEPS + 1];
+
+    zmk_accel_curve_build(curve, exponent);
+
+    for (uint32_t ms = 0; ms < TIME_TO_MAX_MS; ms++) {
+        uint32_t scale = zmk_accel_curve_scale(curve, ms, TIME_TO_MAX_MS);
+        uint32_t expected = reference_scale(ms, TIME_TO_MAX_MS, exponent);
+
+        zassert_true(abs((int32_t)(scale - expected)) <= tolerance,
+                     "Exponent %u at %u ms: got %u, expected %u", exponent, ms, scale, expected);
+    }
+}
+
+ZTEST(accel_curve, test_uniform_acceleration_is_exact) {
+    // A straight line is interpolated exactly, apart from rounding down the fraction.
+    assert_close_to_reference(1, 1);
+}
+
+ZTEST(accel_curve, test_uniform_jerk_is_close) {
+    // Linear interpolation of x^2 over 32 segments is off by at most 1/4096 of full speed.
+    assert_close_to_reference(2, ZMK_ACCEL_SCALE_ONE / 4096 + 1);
+}
+
+ZTEST(accel_curve, test_cubic_is_close) {
+    assert_close_to_reference(3, ZMK_ACCEL_SCALE_ONE / 1024);
+}
+
+ZTEST(accel_curve, test_full_speed_after_time_to_max) {
+    uint32_t curve[ZMK_ACCEL_CURVE_STEPS + 1];
+
+    zmk_accel_curve_build(curve, 2);
+
+    zassert_equal(zmk_accel_curve_scale(curve, TIME_TO_MAX_MS, TIME_TO_MAX_MS),
+                  ZMK_ACCEL_SCALE_ONE);
+    zassert_equal(zmk_accel_curve_scale(curve, 10 * TIME_TO_MAX_MS, TIME_TO_MAX_MS),
+                  ZMK_ACCEL_SCALE_ONE);
+}
+
+ZTEST(accel_curve, test_steep_curve_is_monotonic) {
+    // With a large exponent the last segment rises by almost ZMK_ACCEL_SCALE_ONE, the largest
+    // product interpolation has to handle.
+    uint32_t curve[ZMK_ACCEL_CURVE_STEPS + 1];
+    uint32_t prev = 0;
+
+    zmk_accel_curve_build(curve, UINT8_MAX);
+
+    for (uint32_t ms = 0; ms <= UINT16_MAX; ms++) {
+        uint32_t scale = zmk_accel_curve_scale(curve, ms, UINT16_MAX);
+
+        zassert_true(scale >= prev, "Scale fell from %u to %u at %u ms", prev, scale, ms);
+        zassert_true(scale <= ZMK_ACCEL_SCALE_ONE, "Scale %u above full speed at %u ms", scale,
+                     ms);
+        prev = scale;
+    }
+
+    zassert_equal(prev, ZMK_ACCEL_SCALE_ONE);
+}
+
+ZTEST_SUITE(accel_curve, NULL, NULL, NULL, NULL, NULL);
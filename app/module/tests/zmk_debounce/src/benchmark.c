@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <inttypes.h>
+
+#include <zephyr/timing/timing.h>
+#include <zephyr/ztest.h>
+
+#include <zmk/debounce.h>
+
+// Compares the time to debounce one 32 switch group per scan with the bit-sliced group engine
+// against the per-key zmk_debounce_update() path the matrix driver used before it.
+
+#define SCAN_PERIOD_MS 1
+#define PRESS_MS 5
+#define RELEASE_MS 5
+#define BENCHMARK_SCANS 1000
+
+static uint32_t samples[BENCHMARK_SCANS];
+
+static void fill_samples(void) {
+    // A handful of held keys, with some of them chattering, so both paths do real counter work.
+    uint32_t lfsr = 0xACE1u;
+
+    for (int scan = 0; scan < BENCHMARK_SCANS; scan++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+
+        uint32_t held = (scan / 50) % 2 ? 0x00F0F00F : 0x0F000F00;
+        samples[scan] = held ^ (lfsr & 0x00030003);
+    }
+}
+
+static uint32_t run_per_key(uint64_t *cycles) {
+    const struct zmk_debounce_config config = {
+        .debounce_press_ms = PRESS_MS,
+        .debounce_release_ms = RELEASE_MS,
+    };
+    struct zmk_debounce_state states[ZMK_DEBOUNCE_GROUP_WIDTH] = {0};
+    uint32_t changes = 0;
+
+    timing_t start = timing_counter_get();
+
+    for (int scan = 0; scan < BENCHMARK_SCANS; scan++) {
+        for (int i = 0; i < ZMK_DEBOUNCE_GROUP_WIDTH; i++) {
+            zmk_debounce_update(&states[i], samples[scan] & BIT(i), SCAN_PERIOD_MS, &config);
+            changes += zmk_debounce_get_changed(&states[i]);
+        }
+    }
+
+    timing_t end = timing_counter_get();
+
+    *cycles = timing_cycles_get(&start, &end);
+    return changes;
+}
+
+static uint32_t run_group(uint64_t *cycles) {
+    const struct zmk_debounce_group_config config = {
+        .algorithm = ZMK_DEBOUNCE_ALGORITHM_INTEGRATOR,
+        .press_scans = ZMK_DEBOUNCE_MS_TO_SCANS(PRESS_MS, SCAN_PERIOD_MS),
+        .release_scans = ZMK_DEBOUNCE_MS_TO_SCANS(RELEASE_MS, SCAN_PERIOD_MS),
+    };
+    struct zmk_debounce_group_state state = {0};
+    uint32_t changes = 0;
+
+    timing_t start = timing_counter_get();
+
+    for (int scan = 0; scan < BENCHMARK_SCANS; scan++) {
+        zmk_debounce_group_update(&state, samples[scan], &config);
+        changes += POPCOUNT(zmk_debounce_group_get_changed(&state));
+    }
+
+    timing_t end = timing_counter_get();
+
+    *cycles = timing_cycles_get(&start, &end);
+    return changes;
+}
+
+static void *benchmark_setup(void) {
+    fill_samples();
+    timing_init();
+    timing_start();
+    return NULL;
+}
+
+static void benchmark_teardown(void *fixture) { timing_stop(); }
+
+ZTEST_SUITE(debounce_benchmark, NULL, benchmark_setup, NULL, NULL, benchmark_teardown);
+
+ZTEST(debounce_benchmark, test_group_scan_time) {
+    uint64_t per_key_cycles, group_cycles;
+
+    uint32_t per_key_changes = run_per_key(&per_key_cycles);
+    uint32_t group_changes = run_group(&group_cycles);
+
+    TC_PRINT("%d scans of %d switches: per-key %" PRIu64 " ns, grouped %" PRIu64 " ns\n",
+             BENCHMARK_SCANS, ZMK_DEBOUNCE_GROUP_WIDTH, timing_cycles_to_ns(per_key_cycles),
+             timing_cycles_to_ns(group_cycles));
+
+    zassert_equal(per_key_changes, group_changes, "Paths latched %u and %u changes",
+                  per_key_changes, group_changes);
+    zassert_true(per_key_changes > 0, "Samples never latched a change");
+    zassert_true(group_cycles < per_key_cycles, "Grouped debounce is not faster");
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include <zmk/debounce.h>
+
+#define PRESS_SCANS 3
+#define RELEASE_SCANS 5
+
+#define MAX_EDGES 8
+
+struct edge {
+    uint16_t scan;
+    bool pressed;
+};
+
+struct trace_result {
+    size_t len;
+    struct edge edges[MAX_EDGES];
+};
+
+// Bounce traces recorded from a switch sampled once per scan. '1' is a closed contact.
+
+// Chatters for five scans when pressed, then for three scans when released.
+static const char *const bouncy_tap = "00101101111111111111"
+                                      "10100000000000000000";
+
+// Chatters for two scans on press and release, shorter than either lockout.
+static const char *const short_bounce_tap = "0001011111111111"
+                                            "01000000000000000";
+
+// A single noise spike on an idle switch.
+static const char *const spike = "000010000000000000";
+
+static struct trace_result run_trace(enum zmk_debounce_algorithm algorithm, const char *trace,
+                                     int bit) {
+    const struct zmk_debounce_group_config config = {
+        .algorithm = algorithm,
+        .press_scans = PRESS_SCANS,
+        .release_scans = RELEASE_SCANS,
+    };
+    struct zmk_debounce_group_state state = {0};
+    struct trace_result result = {0};
+
+    for (size_t scan = 0; scan < strlen(trace); scan++) {
+        zmk_debounce_group_update(&state, trace[scan] == '1' ? BIT(bit) : 0, &config);
+
+        zassert_equal(zmk_debounce_group_get_changed(&state) & ~BIT(bit), 0,
+                      "Untouched switch changed at scan %zu", scan);
+
+        if (zmk_debounce_group_get_changed(&state) & BIT(bit)) {
+            zassert_true(result.len < MAX_EDGES, "Too many edges");
+            result.edges[result.len++] = (struct edge){
+                .scan = scan,
+                .pressed = (zmk_debounce_group_get_pressed(&state) & BIT(bit)) != 0,
+            };
+        }
+    }
+
+    zassert_equal(zmk_debounce_group_get_pressed(&state), 0, "Switch still pressed");
+
+    return result;
+}
+
+static void assert_edges(enum zmk_debounce_algorithm algorithm, const char *trace,
+                         const struct edge *expected, size_t expected_len) {
+    // Every switch in a group must debounce the same way, whichever bit it is.
+    for (int bit = 0; bit < ZMK_DEBOUNCE_GROUP_WIDTH; bit += 31) {
+        struct trace_result result = run_trace(algorithm, trace, bit);
+
+        zassert_equal(result.len, expected_len, "Expected %zu edges, got %zu (bit %d)",
+                      expected_len, result.len, bit);
+
+        for (size_t i = 0; i < expected_len; i++) {
+            zassert_equal(result.edges[i].scan, expected[i].scan,
+                          "Edge %zu at scan %u, expected %u (bit %d)", i, result.edges[i].scan,
+                          expected[i].scan, bit);
+            zassert_equal(result.edges[i].pressed, expected[i].pressed,
+                          "Edge %zu has the wrong direction (bit %d)", i, bit);
+        }
+    }
+}
+
+#define ASSERT_EDGES(algorithm, trace, ...)                                                        \
+    do {                                                                                           \
+        const struct edge expected[] = {__VA_ARGS__};                                              \
+        assert_edges(algorithm, trace, expected, ARRAY_SIZE(expected));                            \
+    } while (0)
+
+#define ASSERT_NO_EDGES(algorithm, trace) assert_edges(algorithm, trace, NULL, 0)
+
+#define PRESS(scan) {scan, true}
+#define RELEASE(scan) {scan, false}
+
+ZTEST_SUITE(debounce, NULL, NULL, NULL, NULL, NULL);
+
+ZTEST(debounce, test_integrator) {
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_INTEGRATOR, bouncy_tap, PRESS(9), RELEASE(28));
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_INTEGRATOR, short_bounce_tap, PRESS(8), RELEASE(23));
+    ASSERT_NO_EDGES(ZMK_DEBOUNCE_ALGORITHM_INTEGRATOR, spike);
+}
+
+ZTEST(debounce, test_eager_defer) {
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_EAGER_DEFER, bouncy_tap, PRESS(2), RELEASE(28));
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_EAGER_DEFER, short_bounce_tap, PRESS(3), RELEASE(23));
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_EAGER_DEFER, spike, PRESS(4), RELEASE(10));
+}
+
+ZTEST(debounce, test_defer_row) {
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_DEFER_ROW, bouncy_tap, PRESS(12), RELEASE(28));
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_DEFER_ROW, short_bounce_tap, PRESS(10), RELEASE(23));
+    ASSERT_NO_EDGES(ZMK_DEBOUNCE_ALGORITHM_DEFER_ROW, spike);
+}
+
+ZTEST(debounce, test_lockout) {
+    // Chatter during the lockout restarts it, so a bounce longer than the lockout still only
+    // produces one press and one release.
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_LOCKOUT, bouncy_tap, PRESS(2), RELEASE(21));
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_LOCKOUT, short_bounce_tap, PRESS(3), RELEASE(16));
+    ASSERT_EDGES(ZMK_DEBOUNCE_ALGORITHM_LOCKOUT, spike, PRESS(4), RELEASE(9));
+}
+
+ZTEST(debounce, test_defer_row_waits_for_whole_group) {
+    const struct zmk_debounce_group_config config = {
+        .algorithm = ZMK_DEBOUNCE_ALGORITHM_DEFER_ROW,
+        .press_scans = PRESS_SCANS,
+        .release_scans = RELEASE_SCANS,
+    };
+    struct zmk_debounce_group_state state = {0};
+
+    // Switch 0 closes cleanly, but switch 1 in the same group keeps chattering until scan 4.
+    const uint32_t samples[] = {BIT(0), BIT(0) | BIT(1), BIT(0), BIT(0) | BIT(1), BIT(0)};
+
+    for (size_t scan = 0; scan < ARRAY_SIZE(samples); scan++) {
+        zmk_debounce_group_update(&state, samples[scan], &config);
+        zassert_equal(zmk_debounce_group_get_changed(&state), 0, "Latched at scan %zu", scan);
+    }
+
+    for (int scan = 0; scan < RELEASE_SCANS - 1; scan++) {
+        zmk_debounce_group_update(&state, BIT(0), &config);
+        zassert_equal(zmk_debounce_group_get_changed(&state), 0, "Latched early");
+    }
+
+    zmk_debounce_group_update(&state, BIT(0), &config);
+    zassert_equal(zmk_debounce_group_get_changed(&state), BIT(0), "Switch 0 did not latch");
+    zassert_equal(zmk_debounce_group_get_pressed(&state), BIT(0), "Wrong switch latched");
+}
@@ -15,6 +15,7 @@
 
 #include <zmk/activity.h>
 #include <zmk/backlight.h>
+#include <zmk/settings.h>
 #include <zmk/usb.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/activity_state_changed.h>
@@ -78,11 +79,8 @@ static int backlight_settings_load_cb(const char *name, size_t len, settings_rea
 SETTINGS_STATIC_HANDLER_DEFINE(backlight, "backlight", NULL, backlight_settings_load_cb, NULL,
                                NULL);
 
-static void backlight_save_work_handler(struct k_work *work) {
-    settings_save_one("backlight/state", &state, sizeof(state));
-}
-
-static struct k_work_delayable backlight_save_work;
+static struct zmk_settings_deferred_save backlight_state_save =
+    ZMK_SETTINGS_DEFERRED_SAVE_INIT("backlight/state", &state, sizeof(state));
 #endif
 
 static int zmk_backlight_init(void) {
@@ -91,9 +89,6 @@ static int zmk_backlight_init(void) {
         return -ENODEV;
     }
 
-#if IS_ENABLED(CONFIG_SETTINGS)
-    k_work_init_delayable(&backlight_save_work, backlight_save_work_handler);
-#endif
 #if IS_ENABLED(CONFIG_ZMK_BACKLIGHT_AUTO_OFF_USB)
     state.on = zmk_usb_is_powered();
 #endif
@@ -107,8 +102,7 @@ static int zmk_backlight_update_and_save(void) {
     }
 
 #if IS_ENABLED(CONFIG_SETTINGS)
-    int ret = k_work_reschedule(&backlight_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
-    return MIN(ret, 0);
+    return zmk_settings_save_deferred(&backlight_state_save);
 #else
     return 0;
 #endif
@@ -12,7 +12,9 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/util.h> // CLAMP
 
+#include <zmk/accel_curve.h>
 #include <zmk/behavior.h>
+#include <zmk/pointing.h>
 #include <dt-bindings/zmk/pointing.h>
 
 #if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
@@ -21,13 +23,17 @@
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+// Moves are speed (units per second) * scale * period (ms), so this is one whole unit of movement.
+#define MOVE_DENOMINATOR ((int64_t)1000 * ZMK_ACCEL_SCALE_ONE)
+
 struct vector2d {
-    float x;
-    float y;
+    int32_t x;
+    int32_t y;
 };
 
 struct movement_state_1d {
-    float remainder;
+    // Sub-unit movement carried over to the next tick, in units of 1 / MOVE_DENOMINATOR.
+    int32_t remainder;
     int16_t speed;
     int64_t start_time;
 };
@@ -42,6 +48,9 @@ struct behavior_input_two_axis_data {
     const struct device *dev;
 
     struct movement_state_2d state;
+
+    // (i / ZMK_ACCEL_CURVE_STEPS) ^ acceleration_exponent for each curve point i.
+    uint32_t curve[ZMK_ACCEL_CURVE_STEPS + 1];
 };
 
 struct behavior_input_two_axis_config {
@@ -56,19 +65,6 @@ struct behavior_input_two_axis_config {
     uint8_t acceleration_exponent;
 };
 
-#if CONFIG_MINIMAL_LIBC
-static float powf(float base, float exponent) {
-    // poor man's power implementation rounds the exponent down to the nearest integer.
-    float power = 1.0f;
-    for (; exponent >= 1.0f; exponent--) {
-        power = power * base;
-    }
-    return power;
-}
-#else
-#include <math.h>
-#endif
-
 static int64_t ticks_since_start(int64_t start, int64_t now, int64_t delay) {
     if (start == 0) {
         return 0;
@@ -108,13 +104,14 @@ static inline uint8_t get_acceleration_exponent(const struct behavior_input_two_
 
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 
-static float speed(const struct behavior_input_two_axis_config *config, uint16_t code,
-                   float max_speed, int64_t duration_ticks) {
+static uint32_t speed_scale(const struct behavior_input_two_axis_config *config,
+                            const uint32_t *curve, uint16_t code, int64_t duration_ticks) {
     uint8_t accel_exp = get_acceleration_exponent(config, code);
+    int64_t duration_ms = k_ticks_to_ms_floor64(duration_ticks);
 
-    if ((1000 * duration_ticks / CONFIG_SYS_CLOCK_TICKS_PER_SEC) > config->time_to_max_speed_ms ||
-        config->time_to_max_speed_ms == 0 || accel_exp == 0) {
-        return max_speed;
+    if (duration_ms > config->time_to_max_speed_ms || config->time_to_max_speed_ms == 0 ||
+        accel_exp == 0) {
+        return ZMK_ACCEL_SCALE_ONE;
     }
 
     // Calculate the speed based on MouseKeysAccel
@@ -123,46 +120,55 @@ static float speed(const struct behavior_input_two_axis_config *config, uint16_t
         return 0;
     }
 
-    float time_fraction = (float)(1000 * duration_ticks / CONFIG_SYS_CLOCK_TICKS_PER_SEC) /
-                          config->time_to_max_speed_ms;
-    return max_speed * powf(time_fraction, accel_exp);
+    return zmk_accel_curve_scale(curve, (uint32_t)duration_ms, config->time_to_max_speed_ms);
 }
 
-static void track_remainder(float *move, float *remainder) {
-    float new_move = *move + *remainder;
-    *remainder = new_move - (int)new_move;
-    *move = (int)new_move;
+static uint8_t tick_period_ms(const struct behavior_input_two_axis_config *config) {
+#if IS_ENABLED(CONFIG_ZMK_INPUT_LISTENER)
+    // Tick on a multiple of the report interval, so each tick's movement lands in its own report.
+    int interval = zmk_pointing_report_interval_ms();
+    if (interval > 1) {
+        return MIN(ROUND_UP(config->trigger_period_ms, interval), UINT8_MAX);
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_INPUT_LISTENER)
+
+    return config->trigger_period_ms;
 }
 
-static float update_movement_1d(const struct behavior_input_two_axis_config *config, uint16_t code,
-                                struct movement_state_1d *state, int64_t now) {
-    float move = 0;
+static int32_t update_movement_1d(const struct behavior_input_two_axis_config *config,
+                                  const uint32_t *curve, uint8_t period_ms, uint16_t code,
+                                  struct movement_state_1d *state, int64_t now) {
     if (state->speed == 0) {
         state->remainder = 0;
-        return move;
+        return 0;
     }
 
     int64_t move_duration = ticks_since_start(state->start_time, now, config->delay_ms);
-    LOG_DBG("Calculated speed: %f", speed(config, code, state->speed, move_duration));
-    move =
-        (move_duration > 0)
-            ? (speed(config, code, state->speed, move_duration) * config->trigger_period_ms / 1000)
-            : 0;
+    if (move_duration <= 0) {
+        return 0;
+    }
+
+    uint32_t scale = speed_scale(config, curve, code, move_duration);
+    LOG_DBG("Calculated speed scale: %u/%lu", scale, ZMK_ACCEL_SCALE_ONE);
+
+    int64_t move = (int64_t)(state->speed * period_ms) * scale + state->remainder;
 
-    track_remainder(&(move), &(state->remainder));
+    // Truncating division keeps the sign of the remainder, so no movement is lost either way.
+    state->remainder = (int32_t)(move % MOVE_DENOMINATOR);
 
-    return move;
+    return (int32_t)(move / MOVE_DENOMINATOR);
 }
-static struct vector2d update_movement_2d(const struct behavior_input_two_axis_config *config,
-                                          struct movement_state_2d *state, int64_t now) {
-    struct vector2d move = {0};
 
-    move = (struct vector2d){
-        .x = update_movement_1d(config, config->x_code, &state->x, now),
-        .y = update_movement_1d(config, config->y_code, &state->y, now),
+static struct vector2d update_movement_2d(const struct behavior_input_two_axis_config *config,
+                                          struct behavior_input_two_axis_data *data, int64_t now) {
+    uint8_t period_ms = tick_period_ms(config);
+
+    return (struct vector2d){
+        .x = update_movement_1d(config, data->curve, period_ms, config->x_code, &data->state.x,
+                                now),
+        .y = update_movement_1d(config, data->curve, period_ms, config->y_code, &data->state.y,
+                                now),
     };
-
-    return move;
 }
 
 static bool is_non_zero_1d_movement(int16_t speed) { return speed != 0; }
@@ -187,7 +193,7 @@ static void tick_work_cb(struct k_work *work) {
     // LOG_INF("x start: %llu, y start: %llu, current timestamp: %llu", data->state.x.start_time,
     //         data->state.y.start_time, timestamp);
 
-    struct vector2d move = update_movement_2d(cfg, &data->state, timestamp);
+    struct vector2d move = update_movement_2d(cfg, data, timestamp);
 
     int ret = 0;
     bool have_x = is_non_zero_1d_movement(move.x);
@@ -202,7 +208,7 @@ static void tick_work_cb(struct k_work *work) {
     }
 
     if (should_be_working(data)) {
-        k_work_schedule(&data->tick_work, K_MSEC(cfg->trigger_period_ms));
+        k_work_schedule(&data->tick_work, K_MSEC(tick_period_ms(cfg)));
     }
 }
 
@@ -225,7 +231,7 @@ static void update_work_scheduling(const struct device *dev) {
     set_start_times_for_activity(&data->state);
 
     if (should_be_working(data)) {
-        k_work_schedule(&data->tick_work, K_MSEC(cfg->trigger_period_ms));
+        k_work_schedule(&data->tick_work, K_MSEC(tick_period_ms(cfg)));
     } else {
         k_work_cancel_delayable(&data->tick_work);
         data->state.y.remainder = 0;
@@ -249,8 +255,10 @@ int behavior_input_two_axis_adjust_speed(const struct device *dev, int16_t dx, i
 
 static int behavior_input_two_axis_init(const struct device *dev) {
     struct behavior_input_two_axis_data *data = dev->data;
+    const struct behavior_input_two_axis_config *cfg = dev->config;
 
     data->dev = dev;
+    zmk_accel_curve_build(data->curve, cfg->acceleration_exponent);
     k_work_init_delayable(&data->tick_work, tick_work_cb);
 
     return 0;
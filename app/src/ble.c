@@ -32,6 +32,8 @@
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/ble.h>
+#include <zmk/settings.h>
+#include <zmk/init.h>
 #include <zmk/keys.h>
 #include <zmk/split/bluetooth/uuid.h>
 #include <zmk/event_manager.h>
@@ -249,16 +251,13 @@ int zmk_ble_profile_index(const bt_addr_le_t *addr) {
 }
 
 #if IS_ENABLED(CONFIG_SETTINGS)
-static void ble_save_profile_work(struct k_work *work) {
-    settings_save_one("ble/active_profile", &active_profile, sizeof(active_profile));
-}
-
-static struct k_work_delayable ble_save_work;
+static struct zmk_settings_deferred_save ble_active_profile_save =
+    ZMK_SETTINGS_DEFERRED_SAVE_INIT("ble/active_profile", &active_profile, sizeof(active_profile));
 #endif
 
 static int ble_save_profile(void) {
 #if IS_ENABLED(CONFIG_SETTINGS)
-    return k_work_reschedule(&ble_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+    return zmk_settings_save_deferred(&ble_active_profile_save);
 #else
     return 0;
 #endif
@@ -719,7 +718,6 @@ static int zmk_ble_init(void) {
 
 #if IS_ENABLED(CONFIG_SETTINGS)
     settings_register(&profiles_handler);
-    k_work_init_delayable(&ble_save_work, ble_save_profile_work);
 #else
     zmk_ble_complete_startup();
 #endif
@@ -811,4 +809,4 @@ ZMK_LISTENER(zmk_ble, zmk_ble_listener);
 ZMK_SUBSCRIPTION(zmk_ble, zmk_keycode_state_changed);
 #endif /* IS_ENABLED(CONFIG_ZMK_BLE_PASSKEY_ENTRY) */
 
-SYS_INIT(zmk_ble_init, APPLICATION, CONFIG_ZMK_BLE_INIT_PRIORITY);
+ZMK_SYS_INIT(zmk_ble_init, APPLICATION, CONFIG_ZMK_BLE_INIT_PRIORITY);
@@ -17,22 +17,31 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include "theme.h"
 
+#include <zmk/display.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/activity_state_changed.h>
 #include <zmk/display/status_screen.h>
 
 static const struct device *display = DEVICE_DT_GET(DT_CHOSEN(zephyr_display));
 static bool initialized = false;
+static bool blanked = true;
 
 static lv_obj_t *screen;
 
 __attribute__((weak)) lv_obj_t *zmk_display_status_screen() { return NULL; }
 
-void display_tick_cb(struct k_work *work) { lv_task_handler(); }
-
+/* Minimum time between two runs of the LVGL task handler, which caps the frame rate. */
 #define TICK_MS 10
 
-K_WORK_DEFINE(display_tick_work, display_tick_cb);
+static int64_t last_tick;
+static uint32_t frames_skipped;
+
+static sys_slist_t pending_widget_updates = SYS_SLIST_STATIC_INIT(&pending_widget_updates);
+static struct k_spinlock widget_updates_lock;
+
+void display_tick_cb(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(display_tick_work, display_tick_cb);
 
 #if IS_ENABLED(CONFIG_ZMK_DISPLAY_WORK_QUEUE_DEDICATED)
 
@@ -50,19 +59,125 @@ struct k_work_q *zmk_display_work_q() {
 #endif
 }
 
-void display_timer_cb() { k_work_submit_to_queue(zmk_display_work_q(), &display_tick_work); }
+/**
+ * Schedule the LVGL task handler to run after `delay_ms`, but no sooner than TICK_MS after its
+ * previous run. If a run is already scheduled at or before that time, it is left as is.
+ */
+static void schedule_tick(uint32_t delay_ms) {
+    const int64_t now = k_uptime_get();
+    const int64_t at = MAX(now + delay_ms, last_tick + TICK_MS);
+    const k_ticks_t delay = k_ms_to_ticks_ceil64(MAX(at - now, 0));
+
+    if (k_work_delayable_is_pending(&display_tick_work) &&
+        k_work_delayable_remaining_get(&display_tick_work) <= delay) {
+        frames_skipped++;
+        return;
+    }
+
+    k_work_reschedule_for_queue(zmk_display_work_q(), &display_tick_work, K_TICKS(delay));
+}
+
+/**
+ * Apply every widget update queued since the last frame. Returns true if any widget was redrawn.
+ */
+static bool run_widget_updates(void) {
+    bool redrawn = false;
+
+    while (true) {
+        k_spinlock_key_t key = k_spin_lock(&widget_updates_lock);
+        sys_snode_t *node = sys_slist_get(&pending_widget_updates);
+        struct zmk_display_widget_update *update =
+            node ? CONTAINER_OF(node, struct zmk_display_widget_update, node) : NULL;
+
+        if (update) {
+            update->pending = false;
+        }
+        k_spin_unlock(&widget_updates_lock, key);
+
+        if (!update) {
+            return redrawn;
+        }
+
+        if (update->update()) {
+            update->redraws++;
+            redrawn = true;
+            LOG_DBG("Redrew %s (%u redraws)", update->name, update->redraws);
+        }
+    }
+}
+
+static void widget_update_work_cb(struct k_work *work) {
+    if (!blanked) {
+        schedule_tick(0);
+    }
+}
+
+K_WORK_DEFINE(widget_update_work, widget_update_work_cb);
+
+void zmk_display_schedule_widget_update(struct zmk_display_widget_update *update) {
+    k_spinlock_key_t key = k_spin_lock(&widget_updates_lock);
+    if (!update->pending) {
+        update->pending = true;
+        sys_slist_append(&pending_widget_updates, &update->node);
+    }
+    k_spin_unlock(&widget_updates_lock, key);
+
+    // Event listeners run on other threads, and the tick state belongs to the display work queue.
+    k_work_submit_to_queue(zmk_display_work_q(), &widget_update_work);
+}
+
+void display_tick_cb(struct k_work *work) {
+    if (blanked) {
+        return;
+    }
+
+    last_tick = k_uptime_get();
+
+    lv_disp_t *disp = lv_disp_get_default();
+    if (run_widget_updates() && disp != NULL) {
+        lv_timer_resume(disp->refr_timer);
+    }
+
+    uint32_t next = lv_task_handler();
+
+    LOG_DBG("Frame took %lld ms", k_uptime_get() - last_tick);
+
+    if (disp != NULL && disp->inv_p == 0) {
+        // Nothing is waiting to be drawn, so LVGL's refresh timer can sleep until a widget
+        // requests a refresh. If it set `next`, the following tick finds nothing due and
+        // returns the real deadline.
+        lv_timer_pause(disp->refr_timer);
+    }
+
+    if (next != LV_NO_TIMER_READY) {
+        schedule_tick(next);
+    }
+}
+
+void zmk_display_request_refresh(void) {
+    lv_disp_t *disp = lv_disp_get_default();
+    if (disp != NULL) {
+        lv_timer_resume(disp->refr_timer);
+    }
+
+    if (!blanked) {
+        schedule_tick(0);
+    }
+}
 
-K_TIMER_DEFINE(display_timer, display_timer_cb, NULL);
+uint32_t zmk_display_get_frames_skipped(void) { return frames_skipped; }
 
 void unblank_display_cb(struct k_work *work) {
     display_blanking_off(display);
-    k_timer_start(&display_timer, K_MSEC(TICK_MS), K_MSEC(TICK_MS));
+    blanked = false;
+    zmk_display_request_refresh();
 }
 
 #if IS_ENABLED(CONFIG_ZMK_DISPLAY_BLANK_ON_IDLE)
 
 void blank_display_cb(struct k_work *work) {
-    k_timer_stop(&display_timer);
+    blanked = true;
+    k_work_cancel_delayable(&display_tick_work);
     display_blanking_on(display);
 }
 K_WORK_DEFINE(blank_display_work, blank_display_cb);
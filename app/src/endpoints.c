@@ -15,10 +15,12 @@
 #include <dt-bindings/zmk/hid_usage_pages.h>
 #include <zmk/usb_hid.h>
 #include <zmk/hog.h>
+#include <zmk/settings.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/ble_active_profile_changed.h>
 #include <zmk/events/usb_conn_state_changed.h>
 #include <zmk/events/endpoint_changed.h>
+#include <zmk/init.h>
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
@@ -33,16 +35,13 @@ static enum zmk_transport preferred_transport =
 static void update_current_endpoint(void);
 
 #if IS_ENABLED(CONFIG_SETTINGS)
-static void endpoints_save_preferred_work(struct k_work *work) {
-    settings_save_one("endpoints/preferred", &preferred_transport, sizeof(preferred_transport));
-}
-
-static struct k_work_delayable endpoints_save_work;
+static struct zmk_settings_deferred_save endpoints_preferred_save = ZMK_SETTINGS_DEFERRED_SAVE_INIT(
+    "endpoints/preferred", &preferred_transport, sizeof(preferred_transport));
 #endif
 
 static int endpoints_save_preferred(void) {
 #if IS_ENABLED(CONFIG_SETTINGS)
-    return k_work_reschedule(&endpoints_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+    return zmk_settings_save_deferred(&endpoints_preferred_save);
 #else
     return 0;
 #endif
@@ -320,10 +319,6 @@ static struct zmk_endpoint_instance get_selected_instance(void) {
 }
 
 static int zmk_endpoints_init(void) {
-#if IS_ENABLED(CONFIG_SETTINGS)
-    k_work_init_delayable(&endpoints_save_work, endpoints_save_preferred_work);
-#endif
-
     current_instance = get_selected_instance();
 
     return 0;
@@ -370,4 +365,4 @@ ZMK_SUBSCRIPTION(endpoint_listener, zmk_usb_conn_state_changed);
 ZMK_SUBSCRIPTION(endpoint_listener, zmk_ble_active_profile_changed);
 #endif
 
-SYS_INIT(zmk_endpoints_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+ZMK_SYS_INIT(zmk_endpoints_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/iterable_sections.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/init.h>
+
+#if IS_ENABLED(CONFIG_ZMK_BOOT_PROFILING)
+
+struct boot_profile_entry {
+    const char *name;
+    uint32_t cycles;
+};
+
+static struct boot_profile_entry boot_profile[CONFIG_ZMK_BOOT_PROFILING_MAX_ENTRIES];
+static size_t boot_profile_len;
+
+void zmk_boot_profile_record(const char *name, uint32_t cycles) {
+    if (boot_profile_len >= ARRAY_SIZE(boot_profile)) {
+        LOG_WRN("No room to record boot step %s", name);
+        return;
+    }
+
+    boot_profile[boot_profile_len++] = (struct boot_profile_entry){
+        .name = name,
+        .cycles = cycles,
+    };
+}
+
+void zmk_boot_profile_report(void) {
+    for (size_t i = 0; i < boot_profile_len; i++) {
+        LOG_INF("Boot step %s took %u us", boot_profile[i].name,
+                k_cyc_to_us_floor32(boot_profile[i].cycles));
+    }
+
+    LOG_INF("Boot finished %u ms after kernel start", k_uptime_get_32());
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_BOOT_PROFILING)
+
+#if IS_ENABLED(CONFIG_ZMK_DEFERRED_INIT)
+
+int zmk_init_run_deferred(void) {
+    STRUCT_SECTION_FOREACH(zmk_deferred_init, entry) {
+        int ret = entry->init();
+        if (ret < 0) {
+            LOG_ERR("Deferred init %s failed (%d)", entry->name, ret);
+        }
+    }
+
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_DEFERRED_INIT)
@@ -6,6 +6,7 @@
 
 #include <drivers/behavior.h>
 #include <zephyr/sys/util.h>
+#include <zephyr/sys/math_extras.h>
 #include <zephyr/settings/settings.h>
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
@@ -21,7 +22,9 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
 #include <zmk/events/layer_state_changed.h>
+#include <zmk/events/keymap_changed.h>
 #include <zmk/events/sensor_event.h>
+#include <zmk/init.h>
 
 static zmk_keymap_layers_state_t _zmk_keymap_layer_state = 0;
 static zmk_keymap_layer_id_t _zmk_keymap_layer_default = 0;
@@ -113,6 +116,65 @@ static struct zmk_behavior_binding
         return (_fail_ret);                                                                        \
     }
 
+// Revisions of the keymap contents. Every binding, name or order change bumps the keymap
+// revision and records it against what changed, so callers can tell what changed since a
+// revision they saw before without comparing the whole keymap.
+static uint32_t keymap_revision = 0;
+static uint32_t keymap_layer_revisions[ZMK_KEYMAP_LAYERS_LEN];
+static uint32_t keymap_layer_order_revision = 0;
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE) || IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
+
+static void keymap_changed(zmk_keymap_layer_id_t layer_id) {
+    keymap_revision++;
+
+    if (layer_id == ZMK_KEYMAP_LAYER_ID_INVAL) {
+        keymap_layer_order_revision = keymap_revision;
+    } else {
+        keymap_layer_revisions[layer_id] = keymap_revision;
+    }
+
+    raise_zmk_keymap_changed(
+        (struct zmk_keymap_changed){.revision = keymap_revision, .layer_id = layer_id});
+}
+
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
+
+static void keymap_layers_changed(zmk_keymap_layers_state_t layers) {
+    if (layers == 0) {
+        return;
+    }
+
+    keymap_revision++;
+
+    for (zmk_keymap_layer_id_t l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
+        if (layers & BIT(l)) {
+            keymap_layer_revisions[l] = keymap_revision;
+        }
+    }
+
+    zmk_keymap_layer_id_t layer_id =
+        (POPCOUNT(layers) == 1) ? (zmk_keymap_layer_id_t)u32_count_trailing_zeros(layers)
+                                : ZMK_KEYMAP_LAYER_ID_INVAL;
+
+    raise_zmk_keymap_changed(
+        (struct zmk_keymap_changed){.revision = keymap_revision, .layer_id = layer_id});
+}
+
+#endif
+
+uint32_t zmk_keymap_get_revision(void) { return keymap_revision; }
+
+uint32_t zmk_keymap_layer_revision(zmk_keymap_layer_id_t layer_id) {
+    ASSERT_LAYER_VAL(layer_id, 0)
+
+    return keymap_layer_revisions[layer_id];
+}
+
+uint32_t zmk_keymap_layer_order_revision(void) { return keymap_layer_order_revision; }
+
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
 uint8_t map_layer_id_to_index(zmk_keymap_layer_id_t layer_id) {
@@ -263,22 +325,15 @@ zmk_keymap_get_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t bind
 
 static uint8_t zmk_keymap_layer_pending_changes[ZMK_KEYMAP_LAYERS_LEN][PENDING_ARRAY_SIZE];
 
-int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t binding_idx,
-                                        struct zmk_behavior_binding binding) {
-    if (binding_idx >= ZMK_KEYMAP_LEN) {
-        return -EINVAL;
-    }
-
+static int get_storage_binding_idx(zmk_keymap_layer_id_t layer_id, uint8_t binding_idx,
+                                   const uint32_t *pos_map, size_t pos_map_len) {
     ASSERT_LAYER_VAL(layer_id, -EINVAL)
 
-    const uint32_t *pos_map;
-    int ret = zmk_physical_layouts_get_selected_to_stock_position_map(&pos_map);
-    if (ret < 0) {
-        LOG_WRN("Failed to get the mapping to determine where to set the binding (%d)", ret);
-        return ret;
+    if (binding_idx >= ZMK_KEYMAP_LEN) {
+        return -EINVAL;
     }
 
-    if (binding_idx >= ret) {
+    if (binding_idx >= pos_map_len) {
         LOG_WRN("Unable to set binding at index %d which isn't mapped", binding_idx);
         return -EINVAL;
     }
@@ -290,24 +345,80 @@ int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t
         return -EINVAL;
     }
 
-    if (memcmp(&zmk_keymap[layer_id][storage_binding_idx], &binding, sizeof(binding)) == 0) {
-        LOG_DBG("Not setting, no change to layer %d at index %d (%d)", layer_id, binding_idx,
-                storage_binding_idx);
-        return 0;
+    return storage_binding_idx;
+}
+
+int zmk_keymap_set_layer_bindings(const struct zmk_keymap_binding_edit *edits, size_t count,
+                                  size_t *failed_idx) {
+    const uint32_t *pos_map;
+    int ret = zmk_physical_layouts_get_selected_to_stock_position_map(&pos_map);
+    if (ret < 0) {
+        LOG_WRN("Failed to get the mapping to determine where to set the binding (%d)", ret);
+        return ret;
+    }
+
+    const size_t pos_map_len = ret;
+
+    // Check every edit before applying any of them, so a bad edit leaves the keymap untouched.
+    for (size_t i = 0; i < count; i++) {
+        ret = get_storage_binding_idx(edits[i].layer_id, edits[i].binding_idx, pos_map,
+                                      pos_map_len);
+        if (ret < 0) {
+            if (failed_idx) {
+                *failed_idx = i;
+            }
+            return ret;
+        }
     }
 
-    uint8_t *pending = zmk_keymap_layer_pending_changes[layer_id];
+    zmk_keymap_layers_state_t changed_layers = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const zmk_keymap_layer_id_t layer_id = edits[i].layer_id;
+        const uint32_t storage_binding_idx =
+            get_storage_binding_idx(layer_id, edits[i].binding_idx, pos_map, pos_map_len);
+
+        if (memcmp(&zmk_keymap[layer_id][storage_binding_idx], &edits[i].binding,
+                   sizeof(edits[i].binding)) == 0) {
+            LOG_DBG("Not setting, no change to layer %d at index %d (%d)", layer_id,
+                    edits[i].binding_idx, storage_binding_idx);
+            continue;
+        }
 
-    WRITE_BIT(pending[storage_binding_idx / 8], storage_binding_idx % 8, 1);
+        uint8_t *pending = zmk_keymap_layer_pending_changes[layer_id];
 
-    // TODO: Need a mutex to protect access to the keymap data?
-    memcpy(&zmk_keymap[layer_id][storage_binding_idx], &binding, sizeof(binding));
+        WRITE_BIT(pending[storage_binding_idx / 8], storage_binding_idx % 8, 1);
+
+        // TODO: Need a mutex to protect access to the keymap data?
+        memcpy(&zmk_keymap[layer_id][storage_binding_idx], &edits[i].binding,
+               sizeof(edits[i].binding));
+
+        WRITE_BIT(changed_layers, layer_id, 1);
+    }
+
+    keymap_layers_changed(changed_layers);
 
     return 0;
 }
 
+int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t binding_idx,
+                                        struct zmk_behavior_binding binding) {
+    const struct zmk_keymap_binding_edit edit = {
+        .layer_id = layer_id,
+        .binding_idx = binding_idx,
+        .binding = binding,
+    };
+
+    return zmk_keymap_set_layer_bindings(&edit, 1, NULL);
+}
+
 #else
 
+int zmk_keymap_set_layer_bindings(const struct zmk_keymap_binding_edit *edits, size_t count,
+                                  size_t *failed_idx) {
+    return -ENOTSUP;
+}
+
 int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t binding_idx,
                                         struct zmk_behavior_binding binding) {
     return -ENOTSUP;
@@ -346,6 +457,8 @@ int zmk_keymap_move_layer(zmk_keymap_layer_index_t start_idx, zmk_keymap_layer_i
         keymap_layer_orders[dest_idx] = val;
     }
 
+    keymap_changed(ZMK_KEYMAP_LAYER_ID_INVAL);
+
     return 0;
 }
 
@@ -364,6 +477,7 @@ int zmk_keymap_add_layer(void) {
         for (int candidate_id = 0; candidate_id < ZMK_KEYMAP_LAYERS_LEN; candidate_id++) {
             if (!(seen_layer_ids & BIT(candidate_id))) {
                 keymap_layer_orders[index] = candidate_id;
+                keymap_changed(ZMK_KEYMAP_LAYER_ID_INVAL);
                 return index;
             }
         }
@@ -391,6 +505,8 @@ int zmk_keymap_remove_layer(zmk_keymap_layer_index_t index) {
 
     LOG_HEXDUMP_DBG(keymap_layer_orders, ZMK_KEYMAP_LAYERS_LEN, "Order");
 
+    keymap_changed(ZMK_KEYMAP_LAYER_ID_INVAL);
+
     return 0;
 }
 
@@ -404,6 +520,8 @@ int zmk_keymap_restore_layer(zmk_keymap_layer_id_t id, zmk_keymap_layer_index_t
 
     keymap_layer_orders[at_index] = id;
 
+    keymap_changed(ZMK_KEYMAP_LAYER_ID_INVAL);
+
     return 0;
 }
 
@@ -423,6 +541,8 @@ int zmk_keymap_set_layer_name(zmk_keymap_layer_id_t id, const char *name, size_t
 
     WRITE_BIT(changed_layer_names, id, 1);
 
+    keymap_changed(id);
+
     return 0;
 }
 
@@ -459,6 +579,10 @@ struct zmk_behavior_binding_setting {
 } __packed;
 
 int zmk_keymap_check_unsaved_changes(void) {
+    if (changed_layer_names) {
+        return 1;
+    }
+
     for (int l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
         uint8_t *pending = zmk_keymap_layer_pending_changes[l];
         for (int kp = 0; kp < ZMK_KEYMAP_LEN; kp++) {
@@ -597,6 +721,15 @@ static void reload_from_stock_keymap(void) {
     }
 }
 
+static void keymap_reloaded(void) {
+    // Any layer may have changed, so they all take the revision of the reload.
+    for (int l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
+        keymap_layer_revisions[l] = keymap_revision + 1;
+    }
+
+    keymap_changed(ZMK_KEYMAP_LAYER_ID_INVAL);
+}
+
 int zmk_keymap_discard_changes(void) {
     load_stock_keymap_layer_ordering();
     reload_from_stock_keymap();
@@ -610,6 +743,8 @@ int zmk_keymap_discard_changes(void) {
         }
     }
 
+    keymap_reloaded();
+
     return ret;
 }
 
@@ -672,6 +807,8 @@ int zmk_keymap_reset_settings(void) {
 
     reload_from_stock_keymap();
 
+    keymap_reloaded();
+
     return 0;
 }
 
@@ -966,4 +1103,4 @@ int keymap_init(void) {
     return 0;
 }
 
-SYS_INIT(keymap_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+ZMK_SYS_INIT(keymap_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -13,18 +13,28 @@
 LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/display.h>
+#include <zmk/init.h>
 
 int main(void) {
     LOG_INF("Welcome to ZMK!\n");
 
+#if IS_ENABLED(CONFIG_ZMK_DEFERRED_INIT)
+    // Key scanning is already running, so these only delay the work below, not the first key.
+    zmk_init_run_deferred();
+#endif
+
 #if IS_ENABLED(CONFIG_SETTINGS)
     settings_subsys_init();
-    settings_load();
+    ZMK_BOOT_PROFILE_STEP("settings_load", settings_load());
 #endif
 
 #ifdef CONFIG_ZMK_DISPLAY
-    zmk_display_init();
+    ZMK_BOOT_PROFILE_STEP("zmk_display_init", zmk_display_init());
 #endif /* CONFIG_ZMK_DISPLAY */
 
+#if IS_ENABLED(CONFIG_ZMK_BOOT_PROFILING)
+    zmk_boot_profile_report();
+#endif
+
     return 0;
 }
@@ -14,8 +14,10 @@
 #define DT_DRV_COMPAT zmk_matrix_transform
 
 struct zmk_matrix_transform {
-    uint32_t const *lookup_table;
+    /** Array of len entries, each lookup_entry_size bytes wide. */
+    void const *lookup_table;
     size_t len;
+    uint8_t lookup_entry_size;
     uint8_t rows;
     uint8_t columns;
     uint8_t col_offset;
@@ -35,6 +37,11 @@ struct zmk_matrix_transform {
  * initialized to 0, and the keymap index of 0 is a valid index. We want to
  * be able to detect the condition when an unassigned matrix position is
  * pressed and we want to return an error.
+ *
+ * The largest encoded index is the length of the map, so each table uses the
+ * narrowest unsigned type which can hold that value. Since the entries are set
+ * with designated initializers, the table also ends at the last assigned
+ * row,column pair instead of covering the whole matrix.
  */
 
 #define INDEX_OFFSET 1
@@ -45,8 +52,15 @@ struct zmk_matrix_transform {
     [(KT_ROW(DT_INST_PROP_BY_IDX(n, map, i)) * DT_INST_PROP(n, columns)) +                         \
         KT_COL(DT_INST_PROP_BY_IDX(n, map, i))] = i + INDEX_OFFSET
 
+// The largest encoded index is the map length, so uint8_t holds maps of up to 255 keys and
+// uint16_t maps of up to 65535 keys. A map has index N if it is at least N + 1 keys long.
+#define TRANSFORM_LOOKUP_TYPE(n)                                                                   \
+    COND_CODE_1(DT_INST_PROP_HAS_IDX(n, map, 255),                                                 \
+                (COND_CODE_1(DT_INST_PROP_HAS_IDX(n, map, 65535), (uint32_t), (uint16_t))),        \
+                (uint8_t))
+
 #define MATRIX_TRANSFORM_INIT(n)                                                                   \
-    static const uint32_t _CONCAT(zmk_transform_lookup_table_, n)[] = {                            \
+    static const TRANSFORM_LOOKUP_TYPE(n) _CONCAT(zmk_transform_lookup_table_, n)[] = {            \
         LISTIFY(DT_INST_PROP_LEN(n, map), TRANSFORM_LOOKUP_ENTRY, (, ), n)};                       \
     const struct zmk_matrix_transform _CONCAT(zmk_matrix_transform_, DT_DRV_INST(n)) = {           \
         .rows = DT_INST_PROP(n, rows),                                                             \
@@ -55,6 +69,7 @@ struct zmk_matrix_transform {
         .row_offset = DT_INST_PROP(n, row_offset),                                                 \
         .lookup_table = _CONCAT(zmk_transform_lookup_table_, n),                                   \
         .len = ARRAY_SIZE(_CONCAT(zmk_transform_lookup_table_, n)),                                \
+        .lookup_entry_size = sizeof(_CONCAT(zmk_transform_lookup_table_, n)[0]),                   \
     };
 
 DT_INST_FOREACH_STATUS_OKAY(MATRIX_TRANSFORM_INIT);
@@ -87,7 +102,20 @@ int32_t zmk_matrix_transform_row_column_to_position(zmk_matrix_transform_t mt, u
         return -EINVAL;
     }
 
-    int32_t val = mt->lookup_table[lookup_index];
+    int32_t val;
+
+    switch (mt->lookup_entry_size) {
+    case sizeof(uint8_t):
+        val = ((const uint8_t *)mt->lookup_table)[lookup_index];
+        break;
+    case sizeof(uint16_t):
+        val = ((const uint16_t *)mt->lookup_table)[lookup_index];
+        break;
+    default:
+        val = ((const uint32_t *)mt->lookup_table)[lookup_index];
+        break;
+    }
+
     if (val == 0) {
         return -EINVAL;
     }
@@ -9,6 +9,7 @@
 #include <zephyr/pm/device.h>
 #include <zephyr/pm/device_runtime.h>
 #include <zephyr/drivers/kscan.h>
+#include <zephyr/sys/math_extras.h>
 
 #if IS_ENABLED(CONFIG_SETTINGS)
 #include <zephyr/settings/settings.h>
@@ -22,6 +23,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/physical_layouts.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
+#include <zmk/init.h>
 
 ZMK_EVENT_IMPL(zmk_physical_layout_selection_changed);
 
@@ -171,6 +173,8 @@ struct zmk_kscan_event {
     uint32_t row;
     uint32_t column;
     uint32_t state;
+    /** Uptime in ticks when the KSCAN driver reported the event. */
+    int64_t timestamp_ticks;
 };
 
 static struct zmk_kscan_msg_processor {
@@ -180,21 +184,183 @@ static struct zmk_kscan_msg_processor {
 K_MSGQ_DEFINE(physical_layouts_kscan_msgq, sizeof(struct zmk_kscan_event),
               CONFIG_ZMK_KSCAN_EVENT_QUEUE_SIZE, 4);
 
+#define KSCAN_STATE_WORDS DIV_ROUND_UP(ZMK_KEYMAP_LEN, 32)
+
+// If the message queue fills up, events are no longer queued until the
+// processor has caught up. Instead, the latest state reported by the kscan
+// driver for each position is used to synthesize the missing edges.
+static struct k_spinlock kscan_state_lock;
+/** Latest pressed state reported by the kscan driver for each position. */
+static uint32_t kscan_reported_state[KSCAN_STATE_WORDS];
+/** Pressed state for each position as last raised in a position event. */
+static uint32_t kscan_raised_state[KSCAN_STATE_WORDS];
+static bool kscan_overflowed;
+static int64_t kscan_overflow_ticks;
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_EVENT_STATS)
+
+static struct k_spinlock kscan_event_stats_lock;
+static struct zmk_kscan_event_stats kscan_event_stats;
+
+static void record_kscan_event_latency(int64_t latency_ticks) {
+    uint32_t latency_us = (uint32_t)MIN(k_ticks_to_us_floor64(latency_ticks), UINT32_MAX);
+    k_spinlock_key_t key = k_spin_lock(&kscan_event_stats_lock);
+
+    kscan_event_stats.processed++;
+    kscan_event_stats.last_latency_us = latency_us;
+    kscan_event_stats.max_latency_us = MAX(kscan_event_stats.max_latency_us, latency_us);
+    kscan_event_stats.total_latency_us += latency_us;
+
+    k_spin_unlock(&kscan_event_stats_lock, key);
+}
+
+int zmk_physical_layouts_get_kscan_event_stats(struct zmk_kscan_event_stats *stats) {
+    k_spinlock_key_t key = k_spin_lock(&kscan_event_stats_lock);
+    *stats = kscan_event_stats;
+    k_spin_unlock(&kscan_event_stats_lock, key);
+
+    return 0;
+}
+
+static void record_kscan_event_overflow(void) {
+    k_spinlock_key_t key = k_spin_lock(&kscan_event_stats_lock);
+    kscan_event_stats.overflowed++;
+    k_spin_unlock(&kscan_event_stats_lock, key);
+}
+
+static void record_kscan_event_recovered(void) {
+    k_spinlock_key_t key = k_spin_lock(&kscan_event_stats_lock);
+    kscan_event_stats.recovered++;
+    k_spin_unlock(&kscan_event_stats_lock, key);
+}
+
+void zmk_physical_layouts_reset_kscan_event_stats(void) {
+    k_spinlock_key_t key = k_spin_lock(&kscan_event_stats_lock);
+    kscan_event_stats = (struct zmk_kscan_event_stats){0};
+    k_spin_unlock(&kscan_event_stats_lock, key);
+}
+
+#else
+
+int zmk_physical_layouts_get_kscan_event_stats(struct zmk_kscan_event_stats *stats) {
+    return -ENOTSUP;
+}
+
+void zmk_physical_layouts_reset_kscan_event_stats(void) {}
+
+#endif // IS_ENABLED(CONFIG_ZMK_KSCAN_EVENT_STATS)
+
 static void zmk_physical_layout_kscan_callback(const struct device *dev, uint32_t row,
                                                uint32_t column, bool pressed) {
     if (dev != active->kscan) {
         return;
     }
 
+    // KSCAN drivers (and wrappers like the composite and sideband drivers) invoke
+    // this callback synchronously when they detect a change, so capture the time
+    // here rather than when the queued event is eventually processed.
     struct zmk_kscan_event ev = {
         .row = row,
         .column = column,
-        .state = (pressed ? ZMK_KSCAN_EVENT_STATE_PRESSED : ZMK_KSCAN_EVENT_STATE_RELEASED)};
+        .state = (pressed ? ZMK_KSCAN_EVENT_STATE_PRESSED : ZMK_KSCAN_EVENT_STATE_RELEASED),
+        .timestamp_ticks = k_uptime_ticks()};
+
+    int32_t position =
+        zmk_matrix_transform_row_column_to_position(active->matrix_transform, row, column);
+
+    k_spinlock_key_t key = k_spin_lock(&kscan_state_lock);
+
+    if (position >= 0 && position < ZMK_KEYMAP_LEN) {
+        WRITE_BIT(kscan_reported_state[position / 32], position % 32, pressed);
+    }
+
+    // Once an event has been dropped, stop queueing until the processor has
+    // recovered, so that queued events never arrive after the edges it synthesizes.
+    if (!kscan_overflowed && k_msgq_put(&physical_layouts_kscan_msgq, &ev, K_NO_WAIT) != 0) {
+        kscan_overflowed = true;
+    }
+
+    if (kscan_overflowed) {
+        kscan_overflow_ticks = ev.timestamp_ticks;
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_EVENT_STATS)
+        record_kscan_event_overflow();
+#endif
+    }
+
+    k_spin_unlock(&kscan_state_lock, key);
 
-    k_msgq_put(&physical_layouts_kscan_msgq, &ev, K_NO_WAIT);
     k_work_submit(&msg_processor.work);
 }
 
+static void raise_kscan_position_state_changed(uint32_t position, bool pressed,
+                                               int64_t timestamp_ticks) {
+    if (position < ZMK_KEYMAP_LEN) {
+        WRITE_BIT(kscan_raised_state[position / 32], position % 32, pressed);
+    }
+
+    raise_zmk_position_state_changed(
+        (struct zmk_position_state_changed){.source = ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL,
+                                            .state = pressed,
+                                            .position = position,
+                                            .timestamp = k_ticks_to_ms_floor64(timestamp_ticks)});
+}
+
+static void zmk_physical_layouts_kscan_recover_overflow(void) {
+    uint32_t reported[KSCAN_STATE_WORDS];
+    int64_t timestamp_ticks;
+
+    k_spinlock_key_t key = k_spin_lock(&kscan_state_lock);
+
+    if (!kscan_overflowed) {
+        k_spin_unlock(&kscan_state_lock, key);
+        return;
+    }
+
+    // Events queued after the drain loop gave up would be raised twice, once
+    // here and once from the queue. Leave them to the next work run first.
+    if (k_msgq_num_used_get(&physical_layouts_kscan_msgq) > 0) {
+        k_spin_unlock(&kscan_state_lock, key);
+        k_work_submit(&msg_processor.work);
+        return;
+    }
+
+    memcpy(reported, kscan_reported_state, sizeof(reported));
+    timestamp_ticks = kscan_overflow_ticks;
+    kscan_overflowed = false;
+
+    k_spin_unlock(&kscan_state_lock, key);
+
+    LOG_WRN("KSCAN event queue overflowed, synthesizing missed events");
+
+    // Raise the missed releases before the missed presses, so keys which were
+    // never held together are not seen as pressed at the same time.
+    for (int pass = 0; pass < 2; pass++) {
+        const bool pressed = (pass == 1);
+
+        for (int w = 0; w < KSCAN_STATE_WORDS; w++) {
+            uint32_t missed = (reported[w] ^ kscan_raised_state[w]) &
+                              (pressed ? reported[w] : ~reported[w]);
+
+            while (missed) {
+                const int bit = u32_count_trailing_zeros(missed);
+                const uint32_t position = (w * 32) + bit;
+
+                missed &= missed - 1;
+
+                LOG_DBG("Recovered position: %d, pressed: %s", position,
+                        (pressed ? "true" : "false"));
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_EVENT_STATS)
+                record_kscan_event_recovered();
+#endif
+
+                raise_kscan_position_state_changed(position, pressed, timestamp_ticks);
+            }
+        }
+    }
+}
+
 static void zmk_physical_layouts_kscan_process_msgq(struct k_work *item) {
     struct zmk_kscan_event ev;
 
@@ -211,12 +377,17 @@ static void zmk_physical_layouts_kscan_process_msgq(struct k_work *item) {
 
         LOG_DBG("Row: %d, col: %d, position: %d, pressed: %s", ev.row, ev.column, position,
                 (pressed ? "true" : "false"));
-        raise_zmk_position_state_changed(
-            (struct zmk_position_state_changed){.source = ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL,
-                                                .state = pressed,
-                                                .position = position,
-                                                .timestamp = k_uptime_get()});
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_EVENT_STATS)
+        record_kscan_event_latency(k_uptime_ticks() - ev.timestamp_ticks);
+#endif
+
+        raise_kscan_position_state_changed(position, pressed, ev.timestamp_ticks);
     }
+
+    // Every event queued before the overflow has now been raised, so the
+    // remaining difference to the reported state is exactly what was dropped.
+    zmk_physical_layouts_kscan_recover_overflow();
 }
 
 static const struct zmk_physical_layout *get_default_layout(void) {
@@ -277,6 +448,14 @@ int zmk_physical_layouts_select_layout(const struct zmk_physical_layout *dest_la
         return ret;
     }
 
+    // The new kscan device starts with every key released, so state tracked for
+    // the old one must not be used to synthesize edges after an overflow.
+    k_spinlock_key_t key = k_spin_lock(&kscan_state_lock);
+    memset(kscan_reported_state, 0, sizeof(kscan_reported_state));
+    memset(kscan_raised_state, 0, sizeof(kscan_raised_state));
+    kscan_overflowed = false;
+    k_spin_unlock(&kscan_state_lock, key);
+
     active = dest_layout;
 
     if (active->kscan) {
@@ -487,4 +666,4 @@ static int zmk_physical_layouts_init(void) {
     return zmk_physical_layouts_select_initial();
 }
 
-SYS_INIT(zmk_physical_layouts_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+ZMK_SYS_INIT(zmk_physical_layouts_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -26,12 +26,23 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/hid.h>
 #include <zmk/keymap.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/layer_state_changed.h>
 
 #define ONE_IF_DEV_OK(n)                                                                           \
     COND_CODE_1(DT_NODE_HAS_STATUS(DT_INST_PHANDLE(n, device), okay), (1 +), (0 +))
 
 #define VALID_LISTENER_COUNT (DT_INST_FOREACH_STATUS_OKAY(ONE_IF_DEV_OK) 0)
 
+int zmk_pointing_report_interval_ms(void) {
+    switch (zmk_endpoints_selected().transport) {
+    case ZMK_TRANSPORT_BLE:
+        return CONFIG_ZMK_POINTING_REPORT_INTERVAL_BLE_MS;
+    default:
+        return CONFIG_ZMK_POINTING_REPORT_INTERVAL_USB_MS;
+    }
+}
+
 #if VALID_LISTENER_COUNT > 0
 
 enum input_listener_xy_data_mode {
@@ -40,8 +51,9 @@ enum input_listener_xy_data_mode {
     INPUT_LISTENER_XY_DATA_MODE_ABS,
 };
 
+// Summed in 32 bits so a fast device can't overflow a single sync frame.
 struct input_listener_axis_data {
-    int16_t value;
+    int32_t value;
 };
 
 struct input_listener_xy_data {
@@ -70,6 +82,15 @@ struct input_listener_processor_data {
     struct input_processor_remainder_data *remainders;
 };
 
+// One step of a listener's processor chain for the current layer state. `repeat` is the number of
+// times the config is applied, once per active layer it's enabled for.
+struct input_listener_chain_step {
+    const struct input_listener_config_entry *config;
+    struct input_listener_processor_data *processor_data;
+    uint8_t repeat;
+    bool terminal;
+};
+
 struct input_listener_config {
     uint8_t listener_index;
     struct input_listener_config_entry base;
@@ -89,10 +110,15 @@ struct input_listener_data {
     };
 
 #if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
-    int16_t wheel_remainder;
-    int16_t h_wheel_remainder;
+    int32_t wheel_remainder;
+    int32_t h_wheel_remainder;
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 
+    // The processor chain for the layer state at `chain_generation`, rebuilt when it changes.
+    uint32_t chain_generation;
+    uint8_t chain_len;
+    struct input_listener_chain_step *chain;
+
     struct input_listener_processor_data base_processor_data;
     struct input_listener_processor_data layer_override_data[];
 };
@@ -201,38 +227,96 @@ static int apply_config(uint8_t listener_index, const struct input_listener_conf
     return ZMK_INPUT_PROC_CONTINUE;
 }
 
-static int filter_with_input_config(const struct input_listener_config *cfg,
-                                    struct input_listener_data *data, struct input_event *evt) {
-    if (!evt->dev) {
-        return -ENODEV;
-    }
+// Bumped on every layer state change, so each listener rebuilds its chain on its next event.
+static atomic_t layer_state_generation = ATOMIC_INIT(1);
+
+static void rebuild_processor_chain(const struct input_listener_config *cfg,
+                                    struct input_listener_data *data) {
+    uint8_t len = 0;
 
     for (size_t oi = 0; oi < cfg->layer_overrides_len; oi++) {
         const struct input_listener_layer_override *override = &cfg->layer_overrides[oi];
-        struct input_listener_processor_data *override_data = &data->layer_override_data[oi];
         uint32_t mask = override->layer_mask;
         uint8_t layer = 0;
+        uint8_t active = 0;
+
         while (mask != 0) {
             if (mask & BIT(0) && zmk_keymap_layer_active(layer)) {
-                int ret =
-                    apply_config(cfg->listener_index, &override->config, override_data, data, evt);
-
-                if (ret < 0) {
-                    return ret;
-                }
-                if (!override->process_next) {
-                    return 0;
-                }
+                active++;
             }
 
             layer++;
             mask = mask >> 1;
         }
+
+        if (active == 0) {
+            continue;
+        }
+
+        data->chain[len++] = (struct input_listener_chain_step){
+            .config = &override->config,
+            .processor_data = &data->layer_override_data[oi],
+            .repeat = override->process_next ? active : 1,
+            .terminal = !override->process_next,
+        };
+
+        if (!override->process_next) {
+            data->chain_len = len;
+            return;
+        }
+    }
+
+    data->chain[len++] = (struct input_listener_chain_step){
+        .config = &cfg->base,
+        .processor_data = &data->base_processor_data,
+        .repeat = 1,
+        .terminal = false,
+    };
+
+    data->chain_len = len;
+}
+
+static int filter_with_input_config(const struct input_listener_config *cfg,
+                                    struct input_listener_data *data, struct input_event *evt) {
+    if (!evt->dev) {
+        return -ENODEV;
+    }
+
+    uint32_t generation = (uint32_t)atomic_get(&layer_state_generation);
+    if (data->chain_generation != generation) {
+        rebuild_processor_chain(cfg, data);
+        data->chain_generation = generation;
+    }
+
+    int ret = ZMK_INPUT_PROC_CONTINUE;
+
+    for (uint8_t i = 0; i < data->chain_len; i++) {
+        const struct input_listener_chain_step *step = &data->chain[i];
+
+        for (uint8_t r = 0; r < step->repeat; r++) {
+            ret = apply_config(cfg->listener_index, step->config, step->processor_data, data, evt);
+
+            if (ret < 0) {
+                return ret;
+            }
+            if (step->terminal) {
+                return 0;
+            }
+        }
     }
 
-    return apply_config(cfg->listener_index, &cfg->base, &data->base_processor_data, data, evt);
+    return ret;
+}
+
+static int input_listener_layer_state_listener(const zmk_event_t *eh) {
+    atomic_inc(&layer_state_generation);
+
+    return ZMK_EV_EVENT_BUBBLE;
 }
 
+ZMK_LISTENER(input_listener, input_listener_layer_state_listener);
+ZMK_SUBSCRIPTION(input_listener, zmk_layer_state_changed);
+
 static void clear_xy_data(struct input_listener_xy_data *data) {
     data->x.value = data->y.value = 0;
     data->mode = INPUT_LISTENER_XY_DATA_MODE_NONE;
@@ -240,7 +324,7 @@ static void clear_xy_data(struct input_listener_xy_data *data) {
 
 #if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 static void apply_resolution_scaling(struct input_listener_data *data, struct input_event *evt) {
-    int16_t *remainder;
+    int32_t *remainder;
     uint8_t div;
 
     switch (evt->code) {
@@ -256,13 +340,201 @@ static void apply_resolution_scaling(struct input_listener_data *data, struct in
         return;
     }
 
-    int16_t val = evt->value + *remainder;
-    int16_t scaled = val / (int16_t)div;
-    *remainder = val - (scaled * (int16_t)div);
+    int32_t val = evt->value + *remainder;
+    int32_t scaled = val / div;
+    *remainder = val - (scaled * div);
     evt->value = val;
 }
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 
+// Movement and scroll from every listener is summed here and sent as one report, at most once per
+// report interval of the active transport. Button changes are sent straight away.
+struct pointing_report_aggregate {
+    int32_t x, y, wheel, h_wheel;
+    bool has_movement;
+    bool has_scroll;
+};
+
+// The part of the aggregate that fits in a single HID report.
+struct pointing_report_values {
+    int32_t x, y, wheel, h_wheel;
+    bool has_movement;
+    bool has_scroll;
+    uint8_t button_set, button_clear;
+};
+
+static struct pointing_report_aggregate pending_report;
+static int64_t last_report_time;
+
+// Guards `pending_report` and `last_report_time`. Never held across a transport send, so new input
+// can be summed while a BLE report is waiting for room in the notify queue.
+static K_MUTEX_DEFINE(pointing_report_mutex);
+
+// Serializes building and sending the HID mouse report, so reports go out in the order they were
+// taken from the aggregate.
+static K_MUTEX_DEFINE(pointing_send_mutex);
+
+K_THREAD_STACK_DEFINE(pointing_report_q_stack, CONFIG_ZMK_POINTING_REPORT_THREAD_STACK_SIZE);
+
+static struct k_work_q pointing_report_q;
+
+// Takes as much of `*pending` as fits in the report, leaving the rest for the next one.
+static int32_t take_clamped(int32_t *pending, int32_t min, int32_t max) {
+    int32_t val = CLAMP(*pending, min, max);
+    *pending -= val;
+    return val;
+}
+
+// Hosts that enabled a resolution multiplier take the full logical range of the 16 bit wheel
+// fields, others only expect the classic 8 bit range.
+static int32_t take_scroll(int32_t *pending, bool high_res) {
+    if (high_res) {
+        return take_clamped(pending, ZMK_HID_MOUSE_LOGICAL_MIN16, ZMK_HID_MOUSE_LOGICAL_MAX16);
+    }
+
+    return take_clamped(pending, INT8_MIN, INT8_MAX);
+}
+
+static int32_t take_movement(int32_t *pending) {
+    return take_clamped(pending, ZMK_HID_MOUSE_LOGICAL_MIN16, ZMK_HID_MOUSE_LOGICAL_MAX16);
+}
+
+// Called with `pointing_report_mutex` held.
+static void take_pointing_report(struct pointing_report_values *report) {
+    if (pending_report.has_scroll) {
+#if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
+        struct zmk_pointing_resolution_multipliers res =
+            zmk_pointing_resolution_multipliers_get_current_profile();
+        bool hwheel_high_res = res.hor_wheel > 0;
+        bool wheel_high_res = res.wheel > 0;
+#else
+        bool hwheel_high_res = false;
+        bool wheel_high_res = false;
+#endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
+
+        report->has_scroll = true;
+        report->h_wheel = take_scroll(&pending_report.h_wheel, hwheel_high_res);
+        report->wheel = take_scroll(&pending_report.wheel, wheel_high_res);
+        pending_report.has_scroll = pending_report.h_wheel != 0 || pending_report.wheel != 0;
+    }
+
+    if (pending_report.has_movement) {
+        report->has_movement = true;
+        report->x = take_movement(&pending_report.x);
+        report->y = take_movement(&pending_report.y);
+        pending_report.has_movement = pending_report.x != 0 || pending_report.y != 0;
+    }
+
+    last_report_time = k_uptime_get();
+}
+
+// Called with `pointing_send_mutex` held.
+static void send_pointing_report(const struct pointing_report_values *report) {
+    if (report->has_scroll) {
+        zmk_hid_mouse_scroll_set(report->h_wheel, report->wheel);
+    }
+
+    if (report->has_movement) {
+        zmk_hid_mouse_movement_set(report->x, report->y);
+    }
+
+    for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
+        if ((report->button_set & BIT(i)) != 0) {
+            zmk_hid_mouse_button_press(i);
+        }
+    }
+
+    for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
+        if ((report->button_clear & BIT(i)) != 0) {
+            zmk_hid_mouse_button_release(i);
+        }
+    }
+
+    zmk_endpoints_send_mouse_report();
+    zmk_hid_mouse_scroll_set(0, 0);
+    zmk_hid_mouse_movement_set(0, 0);
+}
+
+static void pointing_report_work_cb(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(pointing_report_work, pointing_report_work_cb);
+
+static void flush_pointing_report(uint8_t button_set, uint8_t button_clear) {
+    struct pointing_report_values report = {
+        .button_set = button_set,
+        .button_clear = button_clear,
+    };
+
+    k_mutex_lock(&pointing_send_mutex, K_FOREVER);
+    k_mutex_lock(&pointing_report_mutex, K_FOREVER);
+
+    // An earlier flush may already have sent everything while this was waiting for the lock.
+    bool send = button_set != 0 || button_clear != 0 || pending_report.has_movement ||
+                pending_report.has_scroll;
+
+    if (send) {
+        take_pointing_report(&report);
+
+        // Anything that didn't fit in one report goes out in the next interval.
+        if (pending_report.has_movement || pending_report.has_scroll) {
+            k_work_schedule_for_queue(&pointing_report_q, &pointing_report_work,
+                                      K_MSEC(zmk_pointing_report_interval_ms()));
+        }
+    }
+
+    k_mutex_unlock(&pointing_report_mutex);
+
+    if (send) {
+        send_pointing_report(&report);
+    }
+
+    k_mutex_unlock(&pointing_send_mutex);
+}
+
+static void pointing_report_work_cb(struct k_work *work) { flush_pointing_report(0, 0); }
+
+static void queue_pointing_report(struct input_listener_data *data) {
+    k_mutex_lock(&pointing_report_mutex, K_FOREVER);
+
+    if (data->mouse.wheel_data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
+        pending_report.h_wheel += data->mouse.wheel_data.x.value;
+        pending_report.wheel += data->mouse.wheel_data.y.value;
+        pending_report.has_scroll = true;
+    }
+
+    if (data->mouse.data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
+        pending_report.x += data->mouse.data.x.value;
+        pending_report.y += data->mouse.data.y.value;
+        pending_report.has_movement = true;
+    }
+
+    bool buttons_changed = data->mouse.button_set != 0 || data->mouse.button_clear != 0;
+    int64_t wait = last_report_time + zmk_pointing_report_interval_ms() - k_uptime_get();
+    bool send_now = buttons_changed || wait <= 0;
+
+    if (!send_now) {
+        // Doesn't move an already scheduled report, so a steady stream can't starve it.
+        k_work_schedule_for_queue(&pointing_report_q, &pointing_report_work, K_MSEC(wait));
+    }
+
+    k_mutex_unlock(&pointing_report_mutex);
+
+    if (send_now) {
+        k_work_cancel_delayable(&pointing_report_work);
+        flush_pointing_report(data->mouse.button_set, data->mouse.button_clear);
+    }
+}
+
+static int pointing_report_q_init(void) {
+    static const struct k_work_queue_config queue_config = {.name = "Pointing Report Work Queue"};
+    k_work_queue_start(&pointing_report_q, pointing_report_q_stack,
+                       K_THREAD_STACK_SIZEOF(pointing_report_q_stack),
+                       CONFIG_ZMK_POINTING_REPORT_THREAD_PRIORITY, &queue_config);
+    return 0;
+}
+
+SYS_INIT(pointing_report_q_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
 static void input_handler(const struct input_listener_config *config,
                           struct input_listener_data *data, struct input_event *evt) {
     // First, process to update the event data as needed.
@@ -292,34 +564,7 @@ static void input_handler(const struct input_listener_config *config,
     }
 
     if (evt->sync) {
-        if (data->mouse.wheel_data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
-            zmk_hid_mouse_scroll_set(data->mouse.wheel_data.x.value,
-                                     data->mouse.wheel_data.y.value);
-        }
-
-        if (data->mouse.data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
-            zmk_hid_mouse_movement_set(data->mouse.data.x.value, data->mouse.data.y.value);
-        }
-
-        if (data->mouse.button_set != 0) {
-            for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                if ((data->mouse.button_set & BIT(i)) != 0) {
-                    zmk_hid_mouse_button_press(i);
-                }
-            }
-        }
-
-        if (data->mouse.button_clear != 0) {
-            for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                if ((data->mouse.button_clear & BIT(i)) != 0) {
-                    zmk_hid_mouse_button_release(i);
-                }
-            }
-        }
-
-        zmk_endpoints_send_mouse_report();
-        zmk_hid_mouse_scroll_set(0, 0);
-        zmk_hid_mouse_movement_set(0, 0);
+        queue_pointing_report(data);
 
         clear_xy_data(&data->mouse.data);
         clear_xy_data(&data->mouse.wheel_data);
@@ -385,8 +630,11 @@ static void input_handler(const struct input_listener_config *config,
                  .layer_overrides_len = (0 DT_INST_FOREACH_CHILD(n, IL_ONE)),                      \
                  .layer_overrides = {DT_INST_FOREACH_CHILD_SEP_VARGS(n, IL_OVERRIDE, (, ), n)},    \
              };                                                                                    \
+         static struct input_listener_chain_step                                                   \
+             chain_##n[(0 DT_INST_FOREACH_CHILD(n, IL_ONE)) + 1];                                  \
          static struct input_listener_data data_##n =                                              \
              {                                                                                     \
+                 .chain = chain_##n,                                                               \
                  .base_processor_data = IL_EXTRACT_DATA(DT_DRV_INST(n), n, base),                  \
                  .layer_override_data = {DT_INST_FOREACH_CHILD_SEP_VARGS(n, IL_OVERRIDE_DATA,      \
                                                                          (, ), n)},                \
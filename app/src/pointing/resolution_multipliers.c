@@ -13,8 +13,26 @@
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+// Tests have no host to send the resolution multiplier feature report, so they can set the
+// multipliers assumed until one does with a zmk,resolution-multipliers-mock node.
+#if DT_HAS_COMPAT_STATUS_OKAY(zmk_resolution_multipliers_mock)
+
+#define MOCK_NODE DT_INST(0, zmk_resolution_multipliers_mock)
+
+static struct zmk_pointing_resolution_multipliers multipliers[ZMK_ENDPOINT_COUNT] = {
+    [0 ... ZMK_ENDPOINT_COUNT - 1] =
+        {
+            .wheel = DT_PROP(MOCK_NODE, wheel),
+            .hor_wheel = DT_PROP(MOCK_NODE, hor_wheel),
+        },
+};
+
+#else
+
 static struct zmk_pointing_resolution_multipliers multipliers[ZMK_ENDPOINT_COUNT];
 
+#endif
+
 struct zmk_pointing_resolution_multipliers
 zmk_pointing_resolution_multipliers_get_current_profile(void) {
     return zmk_pointing_resolution_multipliers_get_profile(zmk_endpoints_selected());
@@ -9,7 +9,6 @@
 #include <zephyr/kernel.h>
 #include <zephyr/settings/settings.h>
 
-#include <math.h>
 #include <stdlib.h>
 
 #include <zephyr/logging/log.h>
@@ -20,11 +19,16 @@
 #include <zmk/rgb_underglow.h>
 
 #include <zmk/activity.h>
+#include <zmk/matrix.h>
+#include <zmk/physical_layouts.h>
+#include <zmk/settings.h>
 #include <zmk/usb.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/activity_state_changed.h>
+#include <zmk/events/position_state_changed.h>
 #include <zmk/events/usb_conn_state_changed.h>
 #include <zmk/workqueue.h>
+#include <zmk/init.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
@@ -49,6 +53,7 @@ enum rgb_underglow_effect {
     UNDERGLOW_EFFECT_BREATHE,
     UNDERGLOW_EFFECT_SPECTRUM,
     UNDERGLOW_EFFECT_SWIRL,
+    UNDERGLOW_EFFECT_REACTIVE,
     UNDERGLOW_EFFECT_NUMBER // Used to track number of underglow effects
 };
 
@@ -66,6 +71,38 @@ static struct led_rgb pixels[STRIP_NUM_PIXELS];
 
 static struct rgb_underglow_state state;
 
+/* Hue offset of each pixel for the swirl effect. */
+static uint16_t swirl_offsets[STRIP_NUM_PIXELS];
+
+/*
+ * Incremented whenever the state shown by a static effect changes. Ticks stop once the frame for
+ * the current generation has been sent to the strip.
+ */
+static struct k_spinlock tick_lock;
+static uint32_t frame_generation;
+static uint32_t shown_generation;
+
+static void zmk_rgb_underglow_tick_handler(struct k_timer *timer);
+
+K_TIMER_DEFINE(underglow_tick, zmk_rgb_underglow_tick_handler, NULL);
+
+/*
+ * Reactive effect state. Key presses only set bits in reactive_hits, so the input path never waits
+ * for a frame to render. Each tick builds the next frame's per-LED heat (255 = fully lit) from the
+ * previous frame, faded by a fixed step, plus the hits. The previous frame is never written while
+ * the next one is built.
+ */
+static ATOMIC_DEFINE(reactive_hits, STRIP_NUM_PIXELS);
+static atomic_t reactive_hit_time;
+static uint8_t reactive_heat[2][STRIP_NUM_PIXELS];
+static uint8_t reactive_front;
+static bool reactive_lit;
+
+/* Layout used to map key positions to LEDs, and the horizontal extent of its keys. */
+static int reactive_layout = -1;
+static int16_t reactive_min_x;
+static int16_t reactive_max_x;
+
 #if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_EXT_POWER)
 static const struct device *const ext_power = DEVICE_DT_GET(DT_INST(0, zmk_ext_power_generic));
 #endif
@@ -82,17 +119,16 @@ static struct zmk_led_hsb hsb_scale_zero_max(struct zmk_led_hsb hsb) {
 }
 
 static struct led_rgb hsb_to_rgb(struct zmk_led_hsb hsb) {
-    float r = 0, g = 0, b = 0;
-
-    uint8_t i = hsb.h / 60;
-    float v = hsb.b / ((float)BRT_MAX);
-    float s = hsb.s / ((float)SAT_MAX);
-    float f = hsb.h / ((float)HUE_MAX) * 6 - i;
-    float p = v * (1 - s);
-    float q = v * (1 - f * s);
-    float t = v * (1 - (1 - f) * s);
-
-    switch (i % 6) {
+    // Fixed point: v, p, q and t are fractions of HUE_MAX * SAT_MAX * BRT_MAX.
+    const uint32_t scale = HUE_MAX * SAT_MAX * BRT_MAX;
+    const uint32_t f = (hsb.h * 6) % HUE_MAX;
+    const uint32_t v = hsb.b * HUE_MAX * SAT_MAX;
+    const uint32_t p = hsb.b * HUE_MAX * (SAT_MAX - hsb.s);
+    const uint32_t q = hsb.b * (HUE_MAX * SAT_MAX - f * hsb.s);
+    const uint32_t t = hsb.b * (HUE_MAX * SAT_MAX - (HUE_MAX - f) * hsb.s);
+    uint32_t r = 0, g = 0, b = 0;
+
+    switch ((hsb.h / 60) % 6) {
     case 0:
         r = v;
         g = t;
@@ -125,24 +161,26 @@ static struct led_rgb hsb_to_rgb(struct zmk_led_hsb hsb) {
         break;
     }
 
-    struct led_rgb rgb = {r : r * 255, g : g * 255, b : b * 255};
+    struct led_rgb rgb = {r : r * 255 / scale, g : g * 255 / scale, b : b * 255 / scale};
 
     return rgb;
 }
 
-static void zmk_rgb_underglow_effect_solid(void) {
+static void zmk_rgb_underglow_fill(struct led_rgb rgb) {
     for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        pixels[i] = hsb_to_rgb(hsb_scale_min_max(state.color));
+        pixels[i] = rgb;
     }
 }
 
+static void zmk_rgb_underglow_effect_solid(void) {
+    zmk_rgb_underglow_fill(hsb_to_rgb(hsb_scale_min_max(state.color)));
+}
+
 static void zmk_rgb_underglow_effect_breathe(void) {
-    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        struct zmk_led_hsb hsb = state.color;
-        hsb.b = abs(state.animation_step - 1200) / 12;
+    struct zmk_led_hsb hsb = state.color;
+    hsb.b = abs(state.animation_step - 1200) / 12;
 
-        pixels[i] = hsb_to_rgb(hsb_scale_zero_max(hsb));
-    }
+    zmk_rgb_underglow_fill(hsb_to_rgb(hsb_scale_zero_max(hsb)));
 
     state.animation_step += state.animation_speed * 10;
 
@@ -152,30 +190,133 @@ static void zmk_rgb_underglow_effect_breathe(void) {
 }
 
 static void zmk_rgb_underglow_effect_spectrum(void) {
-    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        struct zmk_led_hsb hsb = state.color;
-        hsb.h = state.animation_step;
+    struct zmk_led_hsb hsb = state.color;
+    hsb.h = state.animation_step;
 
-        pixels[i] = hsb_to_rgb(hsb_scale_min_max(hsb));
-    }
+    zmk_rgb_underglow_fill(hsb_to_rgb(hsb_scale_min_max(hsb)));
 
     state.animation_step += state.animation_speed;
     state.animation_step = state.animation_step % HUE_MAX;
 }
 
 static void zmk_rgb_underglow_effect_swirl(void) {
+    struct zmk_led_hsb hsb = hsb_scale_min_max(state.color);
+
     for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        struct zmk_led_hsb hsb = state.color;
-        hsb.h = (HUE_MAX / STRIP_NUM_PIXELS * i + state.animation_step) % HUE_MAX;
+        hsb.h = (swirl_offsets[i] + state.animation_step) % HUE_MAX;
 
-        pixels[i] = hsb_to_rgb(hsb_scale_min_max(hsb));
+        pixels[i] = hsb_to_rgb(hsb);
     }
 
     state.animation_step += state.animation_speed * 2;
     state.animation_step = state.animation_step % HUE_MAX;
 }
 
+static bool zmk_rgb_underglow_reactive_pending(void) {
+    for (int i = 0; i < ARRAY_SIZE(reactive_hits); i++) {
+        if (atomic_get(&reactive_hits[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void zmk_rgb_underglow_reactive_heat(uint8_t *heat, int led, uint8_t value) {
+    if (led >= 0 && led < STRIP_NUM_PIXELS) {
+        heat[led] = MAX(heat[led], value);
+    }
+}
+
+static void zmk_rgb_underglow_effect_reactive(void) {
+    const uint8_t fade = state.animation_speed * 8;
+    const uint8_t *prev = reactive_heat[reactive_front];
+    uint8_t *heat = reactive_heat[!reactive_front];
+    struct zmk_led_hsb hsb = state.color;
+
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        heat[i] = prev[i] > fade ? prev[i] - fade : 0;
+    }
+
+    for (int w = 0; w < ARRAY_SIZE(reactive_hits); w++) {
+        unsigned long hits = (unsigned long)atomic_set(&reactive_hits[w], 0);
+
+        for (int led = w * ATOMIC_BITS; hits; led++, hits >>= 1) {
+            if (!(hits & 1)) {
+                continue;
+            }
+
+            // Light the pressed key's LED, with a ripple into its neighbours.
+            zmk_rgb_underglow_reactive_heat(heat, led, 255);
+            zmk_rgb_underglow_reactive_heat(heat, led - 1, 170);
+            zmk_rgb_underglow_reactive_heat(heat, led + 1, 170);
+            zmk_rgb_underglow_reactive_heat(heat, led - 2, 85);
+            zmk_rgb_underglow_reactive_heat(heat, led + 2, 85);
+        }
+    }
+
+    const atomic_val_t hit_time = atomic_set(&reactive_hit_time, 0);
+    if (hit_time) {
+        LOG_DBG("Reactive key to frame latency: %u ms", k_uptime_get_32() - (uint32_t)hit_time);
+    }
+
+    reactive_lit = false;
+
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        hsb.b = state.color.b * heat[i] / UINT8_MAX;
+        pixels[i] = hsb_to_rgb(hsb_scale_zero_max(hsb));
+        reactive_lit = reactive_lit || heat[i] > 0;
+    }
+
+    reactive_front = !reactive_front;
+}
+
+/* Whether the current effect shows the same frame until the state changes. */
+static bool zmk_rgb_underglow_is_static(void) {
+    switch (state.current_effect) {
+    case UNDERGLOW_EFFECT_SOLID:
+        return true;
+    case UNDERGLOW_EFFECT_REACTIVE:
+        return !reactive_lit && !zmk_rgb_underglow_reactive_pending();
+    default:
+        return false;
+    }
+}
+
+/**
+ * Restart the tick timer and make the next tick redraw the strip, even for a static effect. Must
+ * be called whenever the state changes while the underglow is on.
+ */
+static void zmk_rgb_underglow_start_ticks(void) {
+    k_spinlock_key_t key = k_spin_lock(&tick_lock);
+    frame_generation++;
+    k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(50));
+    k_spin_unlock(&tick_lock, key);
+}
+
+/**
+ * Like zmk_rgb_underglow_start_ticks(), but leaves a running timer alone so frequent callers
+ * don't keep pushing the next tick back.
+ */
+static void zmk_rgb_underglow_keep_ticking(void) {
+    k_spinlock_key_t key = k_spin_lock(&tick_lock);
+    frame_generation++;
+    if (k_timer_remaining_ticks(&underglow_tick) == 0) {
+        k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(50));
+    }
+    k_spin_unlock(&tick_lock, key);
+}
+
 static void zmk_rgb_underglow_tick(struct k_work *work) {
+    k_spinlock_key_t key = k_spin_lock(&tick_lock);
+    const uint32_t generation = frame_generation;
+    k_spin_unlock(&tick_lock, key);
+
+    if (zmk_rgb_underglow_is_static() && generation == shown_generation) {
+        // The strip already shows this frame.
+        return;
+    }
+
     switch (state.current_effect) {
     case UNDERGLOW_EFFECT_SOLID:
         zmk_rgb_underglow_effect_solid();
@@ -189,11 +330,26 @@ static void zmk_rgb_underglow_tick(struct k_work *work) {
     case UNDERGLOW_EFFECT_SWIRL:
         zmk_rgb_underglow_effect_swirl();
         break;
+    case UNDERGLOW_EFFECT_REACTIVE:
+        zmk_rgb_underglow_effect_reactive();
+        break;
     }
 
     int err = led_strip_update_rgb(led_strip, pixels, STRIP_NUM_PIXELS);
     if (err < 0) {
         LOG_ERR("Failed to update the RGB strip (%d)", err);
+        return;
+    }
+
+    if (zmk_rgb_underglow_is_static()) {
+        shown_generation = generation;
+
+        // Nothing changes until the state does, so stop ticking.
+        key = k_spin_lock(&tick_lock);
+        if (generation == frame_generation) {
+            k_timer_stop(&underglow_tick);
+        }
+        k_spin_unlock(&tick_lock, key);
     }
 }
 
@@ -207,8 +363,6 @@ static void zmk_rgb_underglow_tick_handler(struct k_timer *timer) {
     k_work_submit_to_queue(zmk_workqueue_lowprio_work_q(), &underglow_tick_work);
 }
 
-K_TIMER_DEFINE(underglow_tick, zmk_rgb_underglow_tick_handler, NULL);
-
 #if IS_ENABLED(CONFIG_SETTINGS)
 static int rgb_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg) {
     const char *next;
@@ -222,7 +376,7 @@ static int rgb_settings_set(const char *name, size_t len, settings_read_cb read_
         rc = read_cb(cb_arg, &state, sizeof(state));
         if (rc >= 0) {
             if (state.on) {
-                k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(50));
+                zmk_rgb_underglow_start_ticks();
             }
 
             return 0;
@@ -236,11 +390,8 @@ static int rgb_settings_set(const char *name, size_t len, settings_read_cb read_
 
 SETTINGS_STATIC_HANDLER_DEFINE(rgb_underglow, "rgb/underglow", NULL, rgb_settings_set, NULL, NULL);
 
-static void zmk_rgb_underglow_save_state_work(struct k_work *_work) {
-    settings_save_one("rgb/underglow/state", &state, sizeof(state));
-}
-
-static struct k_work_delayable underglow_save_work;
+static struct zmk_settings_deferred_save underglow_state_save =
+    ZMK_SETTINGS_DEFERRED_SAVE_INIT("rgb/underglow/state", &state, sizeof(state));
 #endif
 
 static int zmk_rgb_underglow_init(void) {
@@ -253,6 +404,10 @@ static int zmk_rgb_underglow_init(void) {
     }
 #endif
 
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        swirl_offsets[i] = HUE_MAX * i / STRIP_NUM_PIXELS;
+    }
+
     state = (struct rgb_underglow_state){
         color : {
             h : CONFIG_ZMK_RGB_UNDERGLOW_HUE_START,
@@ -265,25 +420,26 @@ static int zmk_rgb_underglow_init(void) {
         on : IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_ON_START)
     };
 
-#if IS_ENABLED(CONFIG_SETTINGS)
-    k_work_init_delayable(&underglow_save_work, zmk_rgb_underglow_save_state_work);
-#endif
-
 #if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_USB)
     state.on = zmk_usb_is_powered();
 #endif
 
     if (state.on) {
-        k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(50));
+        zmk_rgb_underglow_start_ticks();
     }
 
     return 0;
 }
 
+static void zmk_rgb_underglow_state_changed(void) {
+    if (state.on) {
+        zmk_rgb_underglow_start_ticks();
+    }
+}
+
 int zmk_rgb_underglow_save_state(void) {
 #if IS_ENABLED(CONFIG_SETTINGS)
-    int ret = k_work_reschedule(&underglow_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
-    return MIN(ret, 0);
+    return zmk_settings_save_deferred(&underglow_state_save);
 #else
     return 0;
 #endif
@@ -312,7 +468,7 @@ int zmk_rgb_underglow_on(void) {
 
     state.on = true;
     state.animation_step = 0;
-    k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(50));
+    zmk_rgb_underglow_start_ticks();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -362,6 +518,7 @@ int zmk_rgb_underglow_select_effect(int effect) {
 
     state.current_effect = effect;
     state.animation_step = 0;
+    zmk_rgb_underglow_state_changed();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -380,6 +537,7 @@ int zmk_rgb_underglow_set_hsb(struct zmk_led_hsb color) {
     }
 
     state.color = color;
+    zmk_rgb_underglow_state_changed();
 
     return 0;
 }
@@ -421,6 +579,7 @@ int zmk_rgb_underglow_change_hue(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_hue(direction);
+    zmk_rgb_underglow_state_changed();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -430,6 +589,7 @@ int zmk_rgb_underglow_change_sat(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_sat(direction);
+    zmk_rgb_underglow_state_changed();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -439,6 +599,7 @@ int zmk_rgb_underglow_change_brt(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_brt(direction);
+    zmk_rgb_underglow_state_changed();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -520,4 +681,63 @@ ZMK_SUBSCRIPTION(rgb_underglow, zmk_activity_state_changed);
 ZMK_SUBSCRIPTION(rgb_underglow, zmk_usb_conn_state_changed);
 #endif
 
-SYS_INIT(zmk_rgb_underglow_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+/**
+ * Map a key position to the LED at the same relative horizontal position along the strip, using the
+ * selected physical layout. Falls back to spreading positions evenly along the strip.
+ *
+ * The strip's physical path is not known, so only the key's x position is used. This assumes the
+ * strip runs from left to right; keys in the same column light the same LED.
+ */
+static int zmk_rgb_underglow_reactive_led(uint32_t position) {
+    struct zmk_physical_layout const *const *layouts;
+    const size_t layouts_len = zmk_physical_layouts_get_list(&layouts);
+    const int selected = zmk_physical_layouts_get_selected();
+
+    if (selected < 0 || selected >= layouts_len || position >= layouts[selected]->keys_len) {
+        return position * STRIP_NUM_PIXELS / ZMK_KEYMAP_LEN;
+    }
+
+    const struct zmk_physical_layout *layout = layouts[selected];
+
+    if (selected != reactive_layout) {
+        reactive_min_x = INT16_MAX;
+        reactive_max_x = INT16_MIN;
+
+        for (int i = 0; i < layout->keys_len; i++) {
+            reactive_min_x = MIN(reactive_min_x, layout->keys[i].x);
+            reactive_max_x = MAX(reactive_max_x, layout->keys[i].x);
+        }
+
+        reactive_layout = selected;
+    }
+
+    if (reactive_max_x <= reactive_min_x) {
+        return 0;
+    }
+
+    return (layout->keys[position].x - reactive_min_x) * (STRIP_NUM_PIXELS - 1) /
+           (reactive_max_x - reactive_min_x);
+}
+
+static int rgb_underglow_reactive_listener(const zmk_event_t *eh) {
+    const struct zmk_position_state_changed *ev = as_zmk_position_state_changed(eh);
+
+    if (ev == NULL || !ev->state || !state.on ||
+        state.current_effect != UNDERGLOW_EFFECT_REACTIVE) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    const int led = zmk_rgb_underglow_reactive_led(ev->position);
+    if (led >= 0 && led < STRIP_NUM_PIXELS) {
+        atomic_set_bit(reactive_hits, led);
+        atomic_cas(&reactive_hit_time, 0, (atomic_val_t)(k_uptime_get_32() | 1));
+        zmk_rgb_underglow_keep_ticking();
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(rgb_underglow_reactive, rgb_underglow_reactive_listener);
+ZMK_SUBSCRIPTION(rgb_underglow_reactive, zmk_position_state_changed);
+
+ZMK_DEFERRED_SYS_INIT(zmk_rgb_underglow_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/slist.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/settings.h>
+
+// Saves waiting for the next write window. Entries are only ever on the list once, so repeated
+// saves of the same setting before the window opens turn into a single flash write.
+static sys_slist_t pending_saves = SYS_SLIST_STATIC_INIT(&pending_saves);
+static struct k_spinlock pending_lock;
+
+static struct zmk_settings_writer_stats writer_stats;
+
+static void settings_writer_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(settings_writer_work, settings_writer_work_handler);
+
+static void settings_writer_work_handler(struct k_work *work) {
+    int64_t start = k_uptime_get();
+    uint32_t written = 0;
+    uint32_t failed = 0;
+
+    while (true) {
+        k_spinlock_key_t key = k_spin_lock(&pending_lock);
+        sys_snode_t *node = sys_slist_get(&pending_saves);
+        struct zmk_settings_deferred_save *save = NULL;
+
+        if (node) {
+            save = CONTAINER_OF(node, struct zmk_settings_deferred_save, node);
+            // Clear before writing, so a change made during the write is saved again.
+            save->pending = false;
+            writer_stats.pending--;
+        }
+
+        k_spin_unlock(&pending_lock, key);
+
+        if (!save) {
+            break;
+        }
+
+        int ret = settings_save_one(save->key, save->value, save->len);
+        if (ret < 0) {
+            LOG_ERR("Failed to save setting %s (%d)", save->key, ret);
+            failed++;
+            continue;
+        }
+
+        written++;
+    }
+
+    uint32_t latency = (uint32_t)(k_uptime_get() - start);
+
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+    writer_stats.writes += written;
+    writer_stats.failures += failed;
+    writer_stats.last_batch_ms = latency;
+    writer_stats.max_batch_ms = MAX(writer_stats.max_batch_ms, latency);
+    k_spin_unlock(&pending_lock, key);
+
+    LOG_DBG("Wrote %d settings in %d ms", written, latency);
+}
+
+int zmk_settings_save_deferred(struct zmk_settings_deferred_save *save) {
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+
+    if (save->pending) {
+        writer_stats.coalesced++;
+    } else {
+        save->pending = true;
+        sys_slist_append(&pending_saves, &save->node);
+        writer_stats.pending++;
+    }
+
+    k_spin_unlock(&pending_lock, key);
+
+    int ret = k_work_reschedule(&settings_writer_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+    return MIN(ret, 0);
+}
+
+void zmk_settings_writer_get_stats(struct zmk_settings_writer_stats *stats) {
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+    *stats = writer_stats;
+    k_spin_unlock(&pending_lock, key);
+}
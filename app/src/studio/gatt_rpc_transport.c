@@ -136,6 +136,7 @@ static void notif_rpc_tx_cb(struct k_work *work) {
     if (!conn) {
         LOG_WRN("No active connection for queued data, dropping");
         ring_buf_reset(tx_buf);
+        zmk_rpc_tx_space_notify();
         return;
     }
 
@@ -154,6 +155,8 @@ static void notif_rpc_tx_cb(struct k_work *work) {
             ring_buf_get_finish(tx_buf, len);
         }
 
+        zmk_rpc_tx_space_notify();
+
         rpc_indicate_params.data = notify_bytes;
         rpc_indicate_params.len = added;
 
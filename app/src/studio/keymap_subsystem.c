@@ -13,6 +13,7 @@ LOG_MODULE_DECLARE(zmk_studio, CONFIG_ZMK_STUDIO_LOG_LEVEL);
 #include <zmk/behavior.h>
 #include <zmk/matrix.h>
 #include <zmk/keymap.h>
+#include <zmk/events/keymap_changed.h>
 #include <zmk/studio/rpc.h>
 #include <zmk/physical_layouts.h>
 
@@ -165,9 +166,6 @@ zmk_studio_Response set_layer_binding(const zmk_studio_Request *req) {
         }
     }
 
-    raise_zmk_studio_rpc_notification((struct zmk_studio_rpc_notification){
-        .notification = KEYMAP_NOTIFICATION(unsaved_changes_status_changed, true)});
-
     return KEYMAP_RESPONSE(set_layer_binding,
                            zmk_keymap_SetLayerBindingResponse_SET_LAYER_BINDING_RESP_OK);
 }
@@ -235,9 +233,6 @@ zmk_studio_Response discard_changes(const zmk_studio_Request *req) {
         return ZMK_RPC_SIMPLE_ERR(GENERIC);
     }
 
-    raise_zmk_studio_rpc_notification((struct zmk_studio_rpc_notification){
-        .notification = KEYMAP_NOTIFICATION(unsaved_changes_status_changed, false)});
-
     return KEYMAP_RESPONSE(discard_changes, true);
 }
 
@@ -370,9 +365,6 @@ zmk_studio_Response move_layer(const zmk_studio_Request *req) {
         resp.which_result = zmk_keymap_SetActivePhysicalLayoutResponse_ok_tag;
         resp.result.ok.layers.funcs.encode = encode_keymap_layers;
         populate_keymap_extra_props(&resp.result.ok);
-
-        raise_zmk_studio_rpc_notification((struct zmk_studio_rpc_notification){
-            .notification = KEYMAP_NOTIFICATION(unsaved_changes_status_changed, true)});
     } else {
         LOG_WRN("Failed to move layer: %d", ret);
         resp.which_result = zmk_keymap_MoveLayerResponse_err_tag;
@@ -406,9 +398,6 @@ zmk_studio_Response add_layer(const zmk_studio_Request *req) {
 
         resp.result.ok.layer.bindings.funcs.encode = encode_layer_bindings;
         resp.result.ok.layer.bindings.arg = &layer_id;
-
-        raise_zmk_studio_rpc_notification((struct zmk_studio_rpc_notification){
-            .notification = KEYMAP_NOTIFICATION(unsaved_changes_status_changed, true)});
     } else {
         LOG_WRN("Failed to add layer: %d", ret);
         resp.which_result = zmk_keymap_AddLayerResponse_err_tag;
@@ -435,9 +424,6 @@ zmk_studio_Response remove_layer(const zmk_studio_Request *req) {
 
     if (ret >= 0) {
         resp.which_result = zmk_keymap_RemoveLayerResponse_ok_tag;
-
-        raise_zmk_studio_rpc_notification((struct zmk_studio_rpc_notification){
-            .notification = KEYMAP_NOTIFICATION(unsaved_changes_status_changed, true)});
     } else {
         LOG_WRN("Failed to rm layer: %d", ret);
         resp.which_result = zmk_keymap_RemoveLayerResponse_err_tag;
@@ -472,9 +458,6 @@ zmk_studio_Response restore_layer(const zmk_studio_Request *req) {
 
         resp.result.ok.bindings.funcs.encode = encode_layer_bindings;
         resp.result.ok.bindings.arg = (void *)&restore_req->layer_id;
-
-        raise_zmk_studio_rpc_notification((struct zmk_studio_rpc_notification){
-            .notification = KEYMAP_NOTIFICATION(unsaved_changes_status_changed, true)});
     } else {
         LOG_WRN("Failed to restore layer: %d", ret);
         resp.which_result = zmk_keymap_RestoreLayerResponse_err_tag;
@@ -505,11 +488,7 @@ zmk_studio_Response set_layer_props(const zmk_studio_Request *req) {
 
     int ret = zmk_keymap_set_layer_name(set_req->layer_id, set_req->name, strlen(set_req->name));
 
-    if (ret >= 0) {
-
-        raise_zmk_studio_rpc_notification((struct zmk_studio_rpc_notification){
-            .notification = KEYMAP_NOTIFICATION(unsaved_changes_status_changed, true)});
-    } else {
+    if (ret < 0) {
         LOG_WRN("Failed to set layer props: %d", ret);
         switch (ret) {
         case -EINVAL:
@@ -537,6 +516,18 @@ ZMK_RPC_SUBSYSTEM_HANDLER(keymap, remove_layer, ZMK_STUDIO_RPC_HANDLER_SECURED);
 ZMK_RPC_SUBSYSTEM_HANDLER(keymap, restore_layer, ZMK_STUDIO_RPC_HANDLER_SECURED);
 ZMK_RPC_SUBSYSTEM_HANDLER(keymap, set_layer_props, ZMK_STUDIO_RPC_HANDLER_SECURED);
 
-static int event_mapper(const zmk_event_t *eh, zmk_studio_Notification *n) { return 0; }
+static int event_mapper(const zmk_event_t *eh, zmk_studio_Notification *n) {
+    if (!as_zmk_keymap_changed(eh)) {
+        return -ENOTSUP;
+    }
+
+    // Discarding changes reloads the keymap and raises the event too, so report the actual state
+    // rather than assuming every change leaves something to save.
+    bool unsaved = zmk_physical_layouts_check_unsaved_selection() > 0 ||
+                   zmk_keymap_check_unsaved_changes() > 0;
+
+    *n = KEYMAP_NOTIFICATION(unsaved_changes_status_changed, unsaved);
+    return 0;
+}
 
-ZMK_RPC_EVENT_MAPPER(keymap, event_mapper);
+ZMK_RPC_EVENT_MAPPER(keymap, event_mapper, zmk_keymap_changed);
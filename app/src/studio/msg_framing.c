@@ -7,6 +7,8 @@
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+#include <string.h>
+
 #include "msg_framing.h"
 
 static bool process_byte_err_state(enum studio_framing_state *rpc_framing_state, uint8_t c) {
@@ -77,4 +79,46 @@ bool studio_framing_process_byte(enum studio_framing_state *rpc_framing_state, u
         LOG_ERR("Unsupported framing state: %d", *rpc_framing_state);
         return false;
     }
-}
\ No newline at end of file
+}
+
+bool studio_framing_is_framing_byte(uint8_t c) {
+    return c == FRAMING_SOF || c == FRAMING_ESC || c == FRAMING_EOF;
+}
+
+size_t studio_framing_data_run_len(const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    while (i < len && !studio_framing_is_framing_byte(data[i])) {
+        i++;
+    }
+
+    return i;
+}
+
+size_t studio_framing_process_buffer(enum studio_framing_state *rpc_framing_state,
+                                     const uint8_t *data, size_t len, uint8_t *out,
+                                     size_t *out_len) {
+    size_t i = 0;
+
+    *out_len = 0;
+
+    while (i < len && *rpc_framing_state != FRAMING_STATE_EOF) {
+        if (*rpc_framing_state == FRAMING_STATE_AWAITING_DATA) {
+            const size_t run = studio_framing_data_run_len(&data[i], len - i);
+
+            if (run > 0) {
+                memcpy(&out[*out_len], &data[i], run);
+                *out_len += run;
+                i += run;
+                continue;
+            }
+        }
+
+        if (studio_framing_process_byte(rpc_framing_state, data[i])) {
+            out[(*out_len)++] = data[i];
+        }
+        i++;
+    }
+
+    return i;
+}
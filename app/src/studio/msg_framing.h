@@ -29,3 +29,25 @@ enum studio_framing_state {
  * has been updated.
  */
 bool studio_framing_process_byte(enum studio_framing_state *frame_state, uint8_t data);
+
+/**
+ * @brief Check if a byte has a framing meaning, and so must be escaped when it appears in data.
+ */
+bool studio_framing_is_framing_byte(uint8_t data);
+
+/**
+ * @brief Get the number of data bytes at the start of a buffer which can be sent without
+ * escaping, i.e. the offset of the first framing byte, or `len` if there is none.
+ */
+size_t studio_framing_data_run_len(const uint8_t *data, size_t len);
+
+/**
+ * @brief Process a buffer of incoming bytes from a frame. Runs of data bytes are copied to `out` in
+ * bulk, and framing bytes update the framing state as with studio_framing_process_byte(). Stops
+ * after the end of a frame, leaving any following bytes for the next frame.
+ * @param out Buffer to receive the data bytes. Must have room for at least `len` bytes.
+ * @param out_len Set to the number of data bytes written to `out`.
+ * @return The number of bytes consumed from `data`.
+ */
+size_t studio_framing_process_buffer(enum studio_framing_state *frame_state, const uint8_t *data,
+                                     size_t len, uint8_t *out, size_t *out_len);
@@ -8,6 +8,7 @@
 
 #include <pb_encode.h>
 #include <pb_decode.h>
+#include <string.h>
 
 #include <zephyr/init.h>
 #include <zephyr/kernel.h>
@@ -21,6 +22,7 @@ LOG_MODULE_REGISTER(zmk_studio, CONFIG_ZMK_STUDIO_LOG_LEVEL);
 #include <zmk/events/endpoint_changed.h>
 #include <zmk/studio/core.h>
 #include <zmk/studio/rpc.h>
+#include <zmk/init.h>
 
 ZMK_EVENT_IMPL(zmk_studio_rpc_notification);
 
@@ -83,24 +85,27 @@ struct ring_buf *zmk_rpc_get_rx_buf(void) { return &rpc_rx_buf; }
 void zmk_rpc_rx_notify(void) { k_sem_give(&rpc_rx_sem); }
 
 static bool rpc_read_cb(pb_istream_t *stream, uint8_t *buf, size_t count) {
-    uint32_t write_offset = 0;
+    size_t write_offset = 0;
 
-    do {
+    // Never claim more than the space left in `buf`. Framing bytes are dropped, so the data
+    // copied out of a claim is never longer than the claim itself.
+    while (write_offset < count && rpc_framing_state != FRAMING_STATE_EOF) {
         uint8_t *buffer;
-        uint32_t len = ring_buf_get_claim(&rpc_rx_buf, &buffer, count);
+        uint32_t len = ring_buf_get_claim(&rpc_rx_buf, &buffer, count - write_offset);
 
-        if (len > 0) {
-            for (int i = 0; i < len; i++) {
-                if (studio_framing_process_byte(&rpc_framing_state, buffer[i])) {
-                    buf[write_offset++] = buffer[i];
-                }
-            }
-        } else {
+        if (len == 0) {
+            ring_buf_get_finish(&rpc_rx_buf, 0);
             k_sem_take(&rpc_rx_sem, K_FOREVER);
+            continue;
         }
 
-        ring_buf_get_finish(&rpc_rx_buf, len);
-    } while (write_offset < count && rpc_framing_state != FRAMING_STATE_EOF);
+        size_t data_len;
+        size_t consumed = studio_framing_process_buffer(&rpc_framing_state, buffer, len,
+                                                        &buf[write_offset], &data_len);
+
+        write_offset += data_len;
+        ring_buf_get_finish(&rpc_rx_buf, consumed);
+    }
 
     if (rpc_framing_state == FRAMING_STATE_EOF) {
         stream->bytes_left = 0;
@@ -117,56 +122,67 @@ static pb_istream_t pb_istream_for_rx_ring_buf() {
 
 RING_BUF_DECLARE(rpc_tx_buf, CONFIG_ZMK_STUDIO_RPC_TX_BUF_SIZE);
 
+static K_SEM_DEFINE(rpc_tx_space_sem, 0, 1);
+
 struct ring_buf *zmk_rpc_get_tx_buf(void) { return &rpc_tx_buf; }
 
+void zmk_rpc_tx_space_notify(void) { k_sem_give(&rpc_tx_space_sem); }
+
+/*
+ * How long to wait for the transport to make room in a full TX buffer before checking again, in
+ * case the transport does not call zmk_rpc_tx_space_notify().
+ */
+#define RPC_TX_SPACE_WAIT K_MSEC(5)
+
 static bool rpc_tx_buffer_write(pb_ostream_t *stream, const uint8_t *buf, size_t count) {
     void *user_data = stream->state;
     size_t written = 0;
 
+    // Set once the escape byte for buf[written] is in the buffer, since the escape and the byte
+    // it escapes may land in separate claims.
     bool escape_byte_already_written = false;
-    do {
+    while (written < count) {
         uint32_t write_idx = 0;
 
         uint8_t *write_buf;
-        uint32_t claim_len = ring_buf_put_claim(&rpc_tx_buf, &write_buf, count - written);
+        uint32_t claim_len = ring_buf_put_claim(&rpc_tx_buf, &write_buf, (count - written) * 2);
 
         if (claim_len == 0) {
+            // Wait for the transport to drain the buffer rather than spinning.
+            ring_buf_put_finish(&rpc_tx_buf, 0);
+            k_sem_take(&rpc_tx_space_sem, RPC_TX_SPACE_WAIT);
             continue;
         }
 
-        int escapes_written = 0;
-        for (int i = 0; i < claim_len && write_idx < claim_len; i++) {
-            uint8_t b = buf[written + i];
-            switch (b) {
-            case FRAMING_EOF:
-            case FRAMING_ESC:
-            case FRAMING_SOF:
-                // Care to be taken. We may need to write the escape byte,
-                // but that's the last available spot for this claim, so we track
-                // if the escape has already been written in the previous iteration
-                // of our loop.
+        while (written < count && write_idx < claim_len) {
+            const uint8_t b = buf[written];
+
+            if (studio_framing_is_framing_byte(b)) {
                 if (!escape_byte_already_written) {
-                    escapes_written++;
                     write_buf[write_idx++] = FRAMING_ESC;
                     escape_byte_already_written = true;
-                    if (write_idx >= claim_len) {
-                        LOG_WRN("Skipping on, no room to write escape and real byte");
-                        continue;
-                    }
+                    continue;
                 }
-            default:
+
                 write_buf[write_idx++] = b;
+                written++;
                 escape_byte_already_written = false;
-                break;
+                continue;
             }
+
+            // Copy the whole run of bytes up to the next one which needs escaping.
+            const size_t run = studio_framing_data_run_len(
+                &buf[written], MIN(count - written, claim_len - write_idx));
+
+            memcpy(&write_buf[write_idx], &buf[written], run);
+            write_idx += run;
+            written += run;
         }
 
         ring_buf_put_finish(&rpc_tx_buf, write_idx);
 
-        written += (write_idx - escapes_written);
-
         selected_transport->tx_notify(&rpc_tx_buf, write_idx, false, user_data);
-    } while (written < count);
+    }
 
     return true;
 }
@@ -311,7 +327,7 @@ static int zmk_rpc_init(void) {
     return 0;
 }
 
-SYS_INIT(zmk_rpc_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+ZMK_DEFERRED_SYS_INIT(zmk_rpc_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
 
 static int studio_rpc_listener_cb(const zmk_event_t *eh) {
     struct zmk_endpoint_changed *ep_changed = as_zmk_endpoint_changed(eh);
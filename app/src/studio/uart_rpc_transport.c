@@ -137,6 +137,8 @@ static void serial_cb(const struct device *dev, void *user_data) {
 
             ring_buf_get_finish(tx_buf, MAX(sent, 0));
         }
+
+        zmk_rpc_tx_space_notify();
     }
 }
 
@@ -23,6 +23,7 @@
 #endif // IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
 
 #include <zmk/event_manager.h>
+#include <zmk/init.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
@@ -251,4 +252,4 @@ static int zmk_usb_hid_init(void) {
     return 0;
 }
 
-SYS_INIT(zmk_usb_hid_init, APPLICATION, CONFIG_ZMK_USB_HID_INIT_PRIORITY);
+ZMK_SYS_INIT(zmk_usb_hid_init, APPLICATION, CONFIG_ZMK_USB_HID_INIT_PRIORITY);